@@ -0,0 +1,294 @@
+#include "benchmark.h"
+#include "processingworker.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+
+// Bump whenever the generated corpus changes, older corpora are then replaced
+static const int CorpusVersion = 1;
+static const quint32 CorpusSeed = 0x7117e9ad;
+static const char* ManifestName = "corpus.json";
+
+// Every thread count is measured this many times, the median is reported
+static const int Repeats = 3;
+
+// Separate processes started for each cold start measurement
+static const int ColdStartRuns = 9;
+
+// Colors of the generated tiles. Few enough that indexed files convert losslessly.
+static const int PaletteSize = 32;
+
+static void print(FILE* stream, const QString& text) {
+    fputs((text + "\n").toStdString().c_str(), stream);
+    fflush(stream);
+}
+
+// A sheet of flat, checkered, striped and round tiles, some fully transparent
+static QImage generateTileset(int cols, int rows, int tileSize, bool indexed, const QList<QRgb>& palette,
+                              QRandomGenerator& random) {
+    QImage image(cols * tileSize, rows * tileSize, QImage::Format_ARGB32);
+    int radius = tileSize / 2;
+    for (int ty = 0; ty < rows; ty++) {
+        for (int tx = 0; tx < cols; tx++) {
+            QRgb base = random.bounded(8) == 0 ? qRgba(0, 0, 0, 0) : palette[random.bounded(PaletteSize)];
+            QRgb accent = palette[random.bounded(PaletteSize)];
+            int pattern = random.bounded(4);
+            for (int y = 0; y < tileSize; y++) {
+                QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(ty * tileSize + y)) + tx * tileSize;
+                for (int x = 0; x < tileSize; x++) {
+                    bool on = false;
+                    switch (pattern) {
+                    case 1:
+                        on = (x / 4 + y / 4) % 2 == 1;
+                        break;
+                    case 2:
+                        on = (x + y) % 8 < 3;
+                        break;
+                    case 3:
+                        on = (x - radius) * (x - radius) + (y - radius) * (y - radius) < radius * radius;
+                        break;
+                    }
+                    line[x] = on ? accent : base;
+                }
+            }
+        }
+    }
+    if (indexed) {
+        return image.convertToFormat(QImage::Format_Indexed8);
+    }
+    return image;
+}
+
+bool Benchmark::generateCorpus(const QString& directory) {
+    QDir(directory).removeRecursively();
+    if (!QDir().mkpath(directory)) {
+        return false;
+    }
+    QRandomGenerator random(CorpusSeed);
+    QList<QRgb> palette;
+    for (int i = 0; i < PaletteSize; i++) {
+        // One draw per statement, the order of argument evaluation isn't fixed
+        int red = random.bounded(256);
+        int green = random.bounded(256);
+        int blue = random.bounded(256);
+        palette.append(qRgb(red, green, blue));
+    }
+
+    QJsonArray files;
+    auto add = [&](const QString& name, int cols, int rows, int tileSize, bool indexed, bool forcePot) {
+        QImage image = generateTileset(cols, rows, tileSize, indexed, palette, random);
+        if (!image.save(QDir(directory).filePath(name), "PNG")) {
+            return false;
+        }
+        QJsonObject file;
+        file["file"] = name;
+        file["tileSize"] = tileSize;
+        file["forcePot"] = forcePot;
+        file["pixels"] = qint64(image.width()) * image.height();
+        files.append(file);
+        return true;
+    };
+
+    print(stdout, "Generating the benchmark corpus...");
+    const int smallTileSizes[] = { 8, 16, 32 };
+    for (int i = 0; i < 240; i++) {
+        int cols = 4 + random.bounded(13);
+        int rows = 4 + random.bounded(13);
+        if (!add(QString("small_%1.png").arg(i, 3, 10, QChar('0')), cols, rows, smallTileSizes[i % 3],
+                 i % 3 == 1, i % 4 == 0)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < 24; i++) {
+        int tileSize = i % 2 == 0 ? 16 : 32;
+        if (!add(QString("medium_%1.png").arg(i, 2, 10, QChar('0')), 1024 / tileSize, 1024 / tileSize,
+                 tileSize, i % 4 == 3, false)) {
+            return false;
+        }
+    }
+    if (!add("huge_0.png", 256, 256, 32, false, false)
+        || !add("huge_1.png", 128, 64, 64, true, false)
+        || !add("huge_2.png", 384, 384, 16, false, true)) {
+        return false;
+    }
+
+    QJsonObject manifest;
+    manifest["version"] = CorpusVersion;
+    manifest["files"] = files;
+    QFile f(QDir(directory).filePath(ManifestName));
+    return f.open(QIODevice::WriteOnly) && f.write(QJsonDocument(manifest).toJson()) > 0;
+}
+
+QList<Benchmark::CorpusFile> Benchmark::prepareCorpus(const QString& directory) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        QFile f(QDir(directory).filePath(ManifestName));
+        QJsonObject manifest;
+        if (f.open(QIODevice::ReadOnly)) {
+            manifest = QJsonDocument::fromJson(f.readAll()).object();
+        }
+
+        QList<CorpusFile> corpus;
+        bool complete = manifest.value("version").toInt() == CorpusVersion;
+        for (const QJsonValue& value : manifest.value("files").toArray()) {
+            QJsonObject file = value.toObject();
+            CorpusFile entry;
+            entry.path = QDir(directory).filePath(file.value("file").toString());
+            entry.settings.tileWidth = file.value("tileSize").toInt();
+            entry.settings.tileHeight = entry.settings.tileWidth;
+            entry.settings.padding = 2;
+            entry.settings.transparent = true;
+            entry.settings.forcePot = file.value("forcePot").toBool();
+            entry.settings.reorder = entry.settings.forcePot;
+            entry.pixels = file.value("pixels").toInteger();
+            complete = complete && QFileInfo::exists(entry.path);
+            corpus.append(entry);
+        }
+        if (complete && !corpus.isEmpty()) {
+            return corpus;
+        }
+        if (attempt == 0 && !generateCorpus(directory)) {
+            break;
+        }
+    }
+    return QList<CorpusFile>();
+}
+
+Benchmark::Pass Benchmark::runPass(const QList<CorpusFile>& corpus, const QString& outputDir, int threads) {
+    // Unchanged exports would skip the write, so every pass starts empty
+    QDir(outputDir).removeRecursively();
+    QDir().mkpath(outputDir);
+
+    Pass pass;
+    ProcessingWorker worker;
+    worker.setMaxThreadCount(threads);
+    QObject::connect(&worker, &ProcessingWorker::fileProcessed, [&pass](const ProcessingResult& result) {
+        if (!result.error.isEmpty() || result.exportResult == ImageWriter::Result::Failed) {
+            pass.failed++;
+        }
+    });
+    QEventLoop loop;
+    QObject::connect(&worker, &ProcessingWorker::finished, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < corpus.size(); i++) {
+        ProcessingJob job;
+        job.fileId = quint64(i + 1);
+        job.sourcePath = corpus[i].path;
+        job.settings = corpus[i].settings;
+        job.exportPath = QDir(outputDir).filePath(QFileInfo(corpus[i].path).fileName());
+        job.keepImage = false;
+        worker.submit(job);
+    }
+    loop.exec();
+    pass.seconds = timer.nsecsElapsed() / 1e9;
+    return pass;
+}
+
+double Benchmark::processSeconds(const QStringList& arguments) {
+    QList<double> seconds;
+    for (int i = 0; i < ColdStartRuns; i++) {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        QElapsedTimer timer;
+        timer.start();
+        process.start(QCoreApplication::applicationFilePath(), arguments);
+        if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            return -1;
+        }
+        seconds.append(timer.nsecsElapsed() / 1e9);
+    }
+    std::sort(seconds.begin(), seconds.end());
+    return seconds[ColdStartRuns / 2];
+}
+
+int Benchmark::run(const QString& directory, int maxThreads) {
+    QString corpusDir = QDir(directory).filePath("corpus");
+    QString outputDir = QDir(directory).filePath("output");
+    QList<CorpusFile> corpus = prepareCorpus(corpusDir);
+    if (corpus.isEmpty()) {
+        print(stderr, QString("Error: Could not create the benchmark corpus in %1").arg(corpusDir));
+        return 1;
+    }
+
+    qint64 pixels = 0;
+    for (const CorpusFile& file : corpus) {
+        pixels += file.pixels;
+    }
+    double megapixels = pixels / 1e6;
+    print(stdout, QString("Corpus: %1 files, %2 MPix").arg(corpus.size()).arg(megapixels, 0, 'f', 1));
+
+    if (maxThreads <= 0) {
+        maxThreads = QThread::idealThreadCount();
+    }
+    QList<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.append(threads);
+    }
+    threadCounts.append(maxThreads);
+
+    // Untimed, so the first measured pass doesn't read the corpus from disk
+    runPass(corpus, outputDir, maxThreads);
+
+    print(stdout, "threads   seconds   files/s    MPix/s   speedup   efficiency");
+    double baseline = 0;
+    int failed = 0;
+    for (int threads : threadCounts) {
+        QList<double> seconds;
+        for (int i = 0; i < Repeats; i++) {
+            Pass pass = runPass(corpus, outputDir, threads);
+            seconds.append(pass.seconds);
+            failed += pass.failed;
+        }
+        std::sort(seconds.begin(), seconds.end());
+        double median = seconds[Repeats / 2];
+        if (baseline == 0) {
+            baseline = median; // One thread
+        }
+        double speedup = baseline / median;
+        print(stdout, QString("%1 %2 %3 %4 %5 %6")
+            .arg(threads, 7)
+            .arg(median, 9, 'f', 3)
+            .arg(corpus.size() / median, 9, 'f', 1)
+            .arg(megapixels / median, 9, 'f', 1)
+            .arg(speedup, 9, 'f', 2)
+            .arg(QString("%1%").arg(speedup / threads * 100, 0, 'f', 0), 12));
+    }
+
+    // Process startup of the CLI alone, and with one small file padded and
+    // written (without the disk cache, so it is padded every time)
+    QDir().mkpath(outputDir);
+    double startup = processSeconds(QStringList() << "--version");
+    double smallFile = processSeconds(QStringList() << "--no-cache" << "-i" << corpus.first().path
+        << "-o" << QDir(outputDir).filePath("cold.png")
+        << "--tile-width" << QString::number(corpus.first().settings.tileWidth)
+        << "--tile-height" << QString::number(corpus.first().settings.tileHeight));
+    QDir(outputDir).removeRecursively();
+    if (startup < 0 || smallFile < 0) {
+        print(stderr, "Error: The CLI could not be started for the cold start measurement");
+        failed++;
+    } else {
+        print(stdout, QString("Cold start: %1 s (--version), %2 s (one small file), median of %3 runs")
+            .arg(startup, 0, 'f', 3).arg(smallFile, 0, 'f', 3).arg(ColdStartRuns));
+    }
+
+    if (failed > 0) {
+        print(stderr, QString("Error: %1 jobs or runs failed").arg(failed));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+#include "projectsettings.h"
+
+// End-to-end throughput of the processing pipeline (decode, pad, encode and
+// write) on a synthetic corpus: many small sheets, some medium and a few huge
+// ones, RGBA and indexed, with several tile sizes. The corpus is generated
+// from a fixed seed, so every machine and release measures the same files. It
+// is kept in the directory and only generated again when the generator
+// changes. Each thread count is run several times, the median is reported.
+// Cold start of the CLI is measured on separate processes of this binary.
+class Benchmark
+{
+public:
+    // Runs with 1, 2, 4, ... threads up to maxThreads (0: one per core) and
+    // prints files/s, MPix/s and scaling efficiency. Returns the exit code.
+    static int run(const QString& directory, int maxThreads);
+
+private:
+    struct CorpusFile {
+        QString path;
+        ProjectSettings settings;
+        qint64 pixels = 0;
+    };
+
+    struct Pass {
+        double seconds = 0;
+        int failed = 0;
+    };
+
+    static QList<CorpusFile> prepareCorpus(const QString& directory);
+    static bool generateCorpus(const QString& directory);
+    static Pass runPass(const QList<CorpusFile>& corpus, const QString& outputDir, int threads);
+
+    // Median wall time of running this executable with the arguments, -1 if a run failed
+    static double processSeconds(const QStringList& arguments);
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,701 @@
+#include "cli.h"
+#include "tileprocessor.h"
+#include "imagewriter.h"
+#include "processingworker.h"
+#include "jobserver.h"
+#include "watchdaemon.h"
+#include "trace.h"
+#include "benchmark.h"
+#include "verifier.h"
+
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QHash>
+#include <QImageReader>
+#include <QRegularExpression>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Input or output path that stands for stdin or stdout
+static const char* StreamPath = "-";
+
+// Where progress lines go, stderr when stdout carries the --stats report
+static FILE* s_status = stdout;
+
+// Stops the trace when the run ends, whichever mode it took
+struct TraceRecording {
+    ~TraceRecording() {
+        Trace::stop();
+    }
+};
+
+// Written next to the project, remembers what each export was built from
+static const char* BuildStateSuffix = ".buildstate";
+
+// Output names for several inputs, same as Project::defaultExportPath()
+static const char* DefaultOutputPattern = "{dir}/{name}.export.{ext}";
+
+// Fixed, so --verify checks the same cases on every run unless asked otherwise
+static const quint32 DefaultVerifySeed = 20240601;
+
+static void print(FILE* stream, const QString& text) {
+    fputs((text + "\n").toStdString().c_str(), stream);
+}
+
+// Image bytes must pass through untranslated
+static void setBinaryMode(FILE* stream) {
+#ifdef Q_OS_WIN
+    _setmode(_fileno(stream), _O_BINARY);
+#else
+    Q_UNUSED(stream);
+#endif
+}
+
+static QJsonObject loadBuildState(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(f.readAll()).object().value("files").toObject();
+}
+
+static bool saveBuildState(const QString& path, const QJsonObject& files) {
+    QJsonObject root;
+    root["version"] = 1;
+    root["files"] = files;
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+static bool isUpToDate(const QJsonObject& record, const QFileInfo& source, const QFileInfo& output, const QString& settingsHash) {
+    if (!output.exists() || record["settings"].toString() != settingsHash) {
+        return false;
+    }
+    // Exports with unchanged bytes keep their old time stamp, so the source time
+    // recorded at the last build counts as well
+    return output.lastModified() >= source.lastModified()
+        || record["sourceModified"].toInteger() == source.lastModified().toMSecsSinceEpoch();
+}
+
+DiskCache* Cli::s_diskCache = nullptr;
+RunStats* Cli::s_stats = nullptr;
+
+int Cli::run(QCoreApplication& app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("TilePad - Tile padding generator/remover");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption inputOption(QStringList() << "i" << "input",
+        "Input image file, directory or wildcard pattern. Can be given more than once.", "file");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+        "Output image file path. With several inputs: a directory or a pattern using {dir}, {name} and {ext} "
+        "(default: {dir}/{name}.export.{ext}).", "file");
+    QCommandLineOption tileWidthOption("tile-width", "Tile width in pixels (default: 16).", "pixels", "16");
+    QCommandLineOption tileHeightOption("tile-height", "Tile height in pixels (default: 16).", "pixels", "16");
+    QCommandLineOption paddingOption(QStringList() << "p" << "padding", "Padding in pixels (default: 1).", "pixels", "1");
+    QCommandLineOption forcePotOption("force-pot", "Force power of two output dimensions.");
+    QCommandLineOption reorderOption("reorder", "Reorder tiles (used with --force-pot).");
+    QCommandLineOption transparentOption("transparent", "Use transparent padding (default).");
+    QCommandLineOption bgColorOption("bg-color", "Background color hex (e.g. FF00FF).", "color", "FF00FF");
+    QCommandLineOption removeOption("remove", "Remove padding instead of adding it.");
+    QCommandLineOption projectOption("project", "TilePad project file (.tilepad).", "file");
+    QCommandLineOption buildOption("build", "Export every out of date file of the --project.");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Files processed in parallel (default: one per core).", "count");
+    QCommandLineOption watchOption("watch", "Pad images whenever they change anywhere under the directory, until stopped.", "dir");
+    QCommandLineOption serveOption("serve", "Read jobs as JSON lines from stdin and reply on stdout until stdin closes.");
+    QCommandLineOption cacheDirOption("cache-dir", "Directory of the export cache, can be shared (default: "
+        + DiskCache::defaultDirectory() + ").", "dir", DiskCache::defaultDirectory());
+    QCommandLineOption cacheSizeOption("cache-size", QString("Export cache size limit in MB (default: %1).")
+        .arg(DiskCache::DefaultLimitMB), "MB", QString::number(DiskCache::DefaultLimitMB));
+    QCommandLineOption formatOption("format", "Output format, png or jpg (default: from the output path, png for -o -).", "format");
+    QCommandLineOption traceOption("trace", "Write the time of every processing stage as Chrome trace events to the file.", "file");
+    QCommandLineOption statsOption("stats", "Print statistics of every file and of the run to stdout. Format: json.", "format");
+    QCommandLineOption benchmarkOption("benchmark", "Measure throughput on a synthetic corpus kept in the directory, "
+        "with 1, 2, 4, ... threads up to --jobs.", "dir");
+    QCommandLineOption verifyOption("verify", "Compare the fast padding paths with the reference implementation "
+        "on the number of random cases.", "cases");
+    QCommandLineOption seedOption("seed", QString("Seed of the --verify cases (default: %1).").arg(DefaultVerifySeed),
+        "n", QString::number(DefaultVerifySeed));
+    QCommandLineOption noCacheOption("no-cache", "Don't look up or store exports in the cache.");
+
+    parser.addOption(inputOption);
+    parser.addOption(outputOption);
+    parser.addOption(tileWidthOption);
+    parser.addOption(tileHeightOption);
+    parser.addOption(paddingOption);
+    parser.addOption(forcePotOption);
+    parser.addOption(reorderOption);
+    parser.addOption(transparentOption);
+    parser.addOption(bgColorOption);
+    parser.addOption(removeOption);
+    parser.addOption(projectOption);
+    parser.addOption(buildOption);
+    parser.addOption(jobsOption);
+    parser.addOption(serveOption);
+    parser.addOption(watchOption);
+    parser.addOption(cacheDirOption);
+    parser.addOption(cacheSizeOption);
+    parser.addOption(noCacheOption);
+    parser.addOption(formatOption);
+    parser.addOption(traceOption);
+    parser.addOption(statsOption);
+    parser.addOption(benchmarkOption);
+    parser.addOption(verifyOption);
+    parser.addOption(seedOption);
+    parser.addPositionalArgument("inputs", "More input files, directories or wildcard patterns.", "[inputs...]");
+
+    parser.process(app);
+    int jobs = parser.isSet(jobsOption) ? parser.value(jobsOption).toInt() : 0;
+
+    // The report is printed when the run ends, whichever mode it took
+    RunStats stats;
+    struct StatsReport {
+        FILE* stream = nullptr;
+        ~StatsReport() {
+            if (stream) {
+                fputs(QJsonDocument(s_stats->toJson()).toJson().constData(), stream);
+                s_stats = nullptr;
+            }
+        }
+    } statsReport;
+    if (parser.isSet(statsOption)) {
+        if (parser.value(statsOption) != "json") {
+            print(stderr, QString("Error: Unsupported stats format: %1").arg(parser.value(statsOption)));
+            return 1;
+        }
+        if (parser.isSet(serveOption) || parser.isSet(watchOption)) {
+            fputs("Error: --stats can't be used with --serve or --watch.\n", stderr);
+            return 1;
+        }
+        // An image written to stdout leaves stderr for the report
+        bool imageToStdout = parser.value(outputOption) == StreamPath
+            || ((parser.values(inputOption) + parser.positionalArguments()).contains(StreamPath) && !parser.isSet(outputOption));
+        s_stats = &stats;
+        s_status = stderr;
+        statsReport.stream = imageToStdout ? stderr : stdout;
+    }
+
+    TraceRecording traceRecording;
+    if (parser.isSet(traceOption) && !Trace::start(parser.value(traceOption))) {
+        print(stderr, QString("Error: Could not write trace: %1").arg(parser.value(traceOption)));
+        return 1;
+    }
+
+    std::unique_ptr<DiskCache> diskCache;
+    qint64 cacheSizeMB = parser.value(cacheSizeOption).toLongLong();
+    if (!parser.isSet(noCacheOption) && cacheSizeMB > 0) {
+        diskCache = std::make_unique<DiskCache>(parser.value(cacheDirOption), cacheSizeMB * 1024 * 1024);
+    }
+    s_diskCache = diskCache.get();
+
+    if (parser.isSet(benchmarkOption)) {
+        return Benchmark::run(parser.value(benchmarkOption), jobs);
+    }
+
+    if (parser.isSet(verifyOption)) {
+        return Verifier::run(parser.value(verifyOption).toInt(), parser.value(seedOption).toUInt());
+    }
+
+    if (parser.isSet(projectOption)) {
+        if (!parser.isSet(buildOption)) {
+            fputs("Error: --project requires --build.\n", stderr);
+            parser.showHelp(1);
+        }
+        return buildProject(parser.value(projectOption), jobs);
+    }
+
+    ProjectSettings settings;
+    settings.tileWidth = parser.value(tileWidthOption).toInt();
+    settings.tileHeight = parser.value(tileHeightOption).toInt();
+    settings.padding = parser.value(paddingOption).toInt();
+    settings.forcePot = parser.isSet(forcePotOption);
+    settings.reorder = parser.isSet(reorderOption);
+    settings.transparent = parser.isSet(transparentOption) || !parser.isSet(bgColorOption);
+    settings.backgroundColor = "#" + parser.value(bgColorOption);
+    settings.removePadding = parser.isSet(removeOption);
+    if (!TileProcessor::isValid(settings)) {
+        print(stderr, QString("Error: Tile sizes must be from 1 to %1 and the padding from 0 to %1.")
+                          .arg(PaddingEngine::MaxTileSize));
+        return 1;
+    }
+
+    // The settings given on the command line are the defaults of every request
+    if (parser.isSet(serveOption)) {
+        JobServer server(settings, jobs);
+        server.setDiskCache(s_diskCache);
+        return server.run();
+    }
+    if (parser.isSet(watchOption)) {
+        QString pattern = outputPattern(parser.value(outputOption));
+        if (pattern.isEmpty()) {
+            fputs("Error: With --watch, --output must be a directory or a pattern containing {name}.\n", stderr);
+            return 1;
+        }
+        WatchDaemon daemon(parser.value(watchOption), pattern, settings, jobs);
+        daemon.setDiskCache(s_diskCache);
+        return daemon.run();
+    }
+
+    QStringList inputs = parser.values(inputOption) + parser.positionalArguments();
+    if (inputs.isEmpty()) {
+        fputs("Error: --input is required.\n", stderr);
+        parser.showHelp(1);
+    }
+    QString output = parser.value(outputOption);
+
+    QString format;
+    if (parser.isSet(formatOption)) {
+        format = ImageWriter::formatForName(parser.value(formatOption));
+        if (format.isEmpty()) {
+            print(stderr, QString("Error: Unsupported format: %1").arg(parser.value(formatOption)));
+            return 1;
+        }
+    }
+
+    // Streams have no name to derive several outputs from
+    bool streaming = inputs.contains(StreamPath) || output == StreamPath;
+    if (streaming && inputs.size() > 1) {
+        fputs("Error: With - as the input or output only one input can be given.\n", stderr);
+        return 1;
+    }
+    if (inputs.first() == StreamPath && output.isEmpty()) {
+        output = StreamPath;
+    }
+
+    // One file to one file stays on the calling thread
+    bool single = inputs.size() == 1 && (inputs.first() == StreamPath || QFileInfo(inputs.first()).isFile())
+        && !output.isEmpty() && !output.contains('{') && !QFileInfo(output).isDir();
+    if (single) {
+        return processImage(inputs.first(), output, format, settings);
+    }
+    if (streaming) {
+        fputs("Error: - can only be used with one input file and one output file.\n", stderr);
+        return 1;
+    }
+    if (!format.isEmpty()) {
+        fputs("Error: --format is only used with a single output.\n", stderr);
+        return 1;
+    }
+    return processBatch(inputs, output, settings, jobs);
+}
+
+int Cli::processImage(const QString& inputPath, const QString& outputPath, const QString& outputFormat,
+                       const ProjectSettings& settings) {
+    bool toStdout = outputPath == StreamPath;
+    QString inputName = inputPath == StreamPath ? "stdin" : inputPath;
+    QString outputName = toStdout ? "stdout" : outputPath;
+
+    // Filled like the worker fills it, for --stats
+    ProcessingResult stats;
+    QElapsedTimer timer;
+    timer.start();
+    qint64 cpuStart = RunStats::threadCpuNs();
+    auto endStage = [&](double* wallMs, double* cpuMs) {
+        *wallMs = timer.nsecsElapsed() / 1000000.0;
+        *cpuMs = (RunStats::threadCpuNs() - cpuStart) / 1000000.0;
+        timer.restart();
+        cpuStart = RunStats::threadCpuNs();
+    };
+    auto fail = [&](const QString& error) {
+        print(stderr, "Error: " + error);
+        if (s_stats) {
+            stats.error = error;
+            s_stats->addResult(inputName, outputName, stats, settings);
+        }
+        return 1;
+    };
+
+    QByteArray sourceData;
+    {
+        TraceScope scope("readSource", 1);
+        QFile sourceFile;
+        if (inputPath == StreamPath) {
+            setBinaryMode(stdin);
+            sourceFile.open(stdin, QIODevice::ReadOnly);
+        } else {
+            sourceFile.setFileName(inputPath);
+            sourceFile.open(QIODevice::ReadOnly);
+        }
+        sourceData = sourceFile.readAll();
+    }
+    stats.bytesRead = sourceData.size();
+
+    QString format = outputFormat.isEmpty() ? ImageWriter::formatForPath(outputPath) : outputFormat;
+    if (format.isEmpty()) {
+        format = "PNG";
+    }
+
+    // A cache hit is written as is, without decoding, padding or encoding
+    QByteArray cacheKey;
+    QByteArray data;
+    if (s_diskCache && !sourceData.isEmpty()) {
+        TraceScope scope("cacheLookup", 1);
+        cacheKey = DiskCache::key(sourceData, settings, format);
+        stats.cached = s_diskCache->find(cacheKey, &data);
+    }
+    if (stats.cached) {
+        if (s_stats) {
+            stats.sourceSize = RunStats::encodedSize(sourceData);
+            stats.outputSize = RunStats::encodedSize(data);
+        }
+        endStage(&stats.decodeMs, &stats.decodeCpuMs);
+    } else {
+        QImage sourceImage;
+        {
+            TraceScope scope("decode", 1);
+            sourceImage = QImage::fromData(sourceData);
+        }
+        if (sourceImage.isNull()) {
+            return fail("Could not load image: " + inputName);
+        }
+        stats.sourceSize = sourceImage.size();
+        endStage(&stats.decodeMs, &stats.decodeCpuMs);
+
+        QImage resultImage;
+        {
+            TraceScope scope(settings.removePadding ? "removePadding" : "pad", 1);
+            resultImage = TileProcessor::process(sourceImage, settings);
+        }
+        stats.outputSize = resultImage.size();
+        endStage(&stats.padMs, &stats.padCpuMs);
+
+        {
+            TraceScope scope("encode", 1);
+            data = ImageWriter::encode(resultImage, format);
+        }
+        if (!data.isEmpty() && s_diskCache) {
+            TraceScope scope("cacheInsert", 1);
+            s_diskCache->insert(cacheKey, data);
+        }
+    }
+    stats.outputBytes = data.size();
+
+    if (toStdout) {
+        // Only the image goes to stdout, so nothing is printed on success
+        setBinaryMode(stdout);
+        QFile out;
+        if (data.isEmpty() || !out.open(stdout, QIODevice::WriteOnly) || out.write(data) != data.size() || !out.flush()) {
+            return fail("Could not write the image to stdout.");
+        }
+        stats.exportResult = ImageWriter::Result::Written;
+        stats.bytesWritten = data.size();
+    } else {
+        if (!data.isEmpty()) {
+            TraceScope scope("write", 1);
+            stats.exportResult = ImageWriter::writeData(data, outputPath);
+        }
+        if (stats.exportResult == ImageWriter::Result::Failed) {
+            return fail("Could not save image: " + outputPath);
+        }
+        if (stats.exportResult == ImageWriter::Result::Skipped) {
+            print(s_status, QString("Unchanged: %1").arg(outputPath));
+        } else {
+            stats.bytesWritten = data.size();
+            print(s_status, QString("Saved: %1").arg(outputPath));
+        }
+    }
+    if (!stats.cached) {
+        endStage(&stats.encodeMs, &stats.encodeCpuMs);
+    }
+    if (s_stats) {
+        s_stats->addResult(inputName, outputName, stats, settings);
+    }
+    return 0;
+}
+
+int Cli::buildProject(const QString& projectPath, int jobs) {
+    Project project;
+    if (!project.load(projectPath)) {
+        print(stderr, QString("Error: Could not open project: %1").arg(projectPath));
+        return 1;
+    }
+    const ProjectSettings& settings = project.settings();
+    if (!TileProcessor::isValid(settings)) {
+        print(stderr, QString("Error: Invalid tile size or padding in project: %1").arg(projectPath));
+        return 1;
+    }
+    QString settingsHash = QString::fromLatin1(ImageWriter::hash(TileProcessor::settingsKey(settings)).toHex());
+    QDir projectDir = QFileInfo(projectPath).absoluteDir();
+
+    QStringList sourcePaths;
+    QStringList exportPaths;
+    for (int i = 0; i < project.fileCount(); i++) {
+        const auto& entry = project.fileAt(i);
+        QString sourcePath = projectDir.absoluteFilePath(entry.sourcePath);
+        sourcePaths.append(sourcePath);
+        exportPaths.append(QDir::cleanPath(entry.exportPath.isEmpty()
+            ? Project::defaultExportPath(sourcePath) : projectDir.absoluteFilePath(entry.exportPath)));
+    }
+
+    // One export would overwrite the other, and the build state would call both up to date
+    QHash<QString, QString> sourceOfExport;
+    int duplicates = 0;
+    for (int i = 0; i < exportPaths.size(); i++) {
+        auto other = sourceOfExport.constFind(exportPaths[i]);
+        if (other == sourceOfExport.constEnd()) {
+            sourceOfExport.insert(exportPaths[i], sourcePaths[i]);
+            continue;
+        }
+        print(stderr, QString("Error: %1 and %2 are both exported to %3")
+            .arg(other.value(), sourcePaths[i], exportPaths[i]));
+        if (s_stats) {
+            s_stats->addStatus(sourcePaths[i], exportPaths[i], "error", "Another file is exported to the same path");
+        }
+        duplicates++;
+    }
+    if (duplicates > 0) {
+        print(s_status, QString("Build failed: %1 export paths are used more than once.").arg(duplicates));
+        return 1;
+    }
+
+    QString statePath = projectPath + BuildStateSuffix;
+    QJsonObject state = loadBuildState(statePath);
+
+    QList<Task> tasks;
+    int upToDate = 0;
+    int failed = 0;
+
+    for (int i = 0; i < project.fileCount(); i++) {
+        const QString& sourcePath = sourcePaths[i];
+        const QString& exportPath = exportPaths[i];
+
+        QFileInfo source(sourcePath);
+        if (!source.exists()) {
+            print(stderr, QString("Error: Source not found: %1").arg(sourcePath));
+            if (s_stats) {
+                s_stats->addStatus(sourcePath, exportPath, "error", "Source not found");
+            }
+            failed++;
+            continue;
+        }
+        if (ImageWriter::formatForPath(exportPath).isEmpty()) {
+            print(stderr, QString("Error: Unsupported export format: %1").arg(exportPath));
+            if (s_stats) {
+                s_stats->addStatus(sourcePath, exportPath, "error", "Unsupported export format");
+            }
+            failed++;
+            continue;
+        }
+        if (isUpToDate(state.value(exportPath).toObject(), source, QFileInfo(exportPath), settingsHash)) {
+            print(s_status, QString("Up to date: %1").arg(exportPath));
+            if (s_stats) {
+                s_stats->addStatus(sourcePath, exportPath, "upToDate");
+            }
+            upToDate++;
+            continue;
+        }
+        tasks.append({ sourcePath, exportPath, source.lastModified().toMSecsSinceEpoch() });
+    }
+
+    Summary summary;
+    if (!tasks.isEmpty()) {
+        summary = processFiles(tasks, settings, jobs, [&](const Task& task) {
+            QJsonObject record;
+            record["settings"] = settingsHash;
+            record["sourceModified"] = task.sourceModified;
+            state[task.outputPath] = record;
+        });
+        if (!saveBuildState(statePath, state)) {
+            print(stderr, QString("Warning: Could not save build state: %1").arg(statePath));
+        }
+    }
+    failed += summary.failed;
+
+    print(s_status, QString("Build finished: %1 saved, %2 unchanged, %3 up to date, %4 failed.")
+        .arg(summary.saved).arg(summary.unchanged).arg(upToDate).arg(failed));
+    return failed > 0 ? 1 : 0;
+}
+
+int Cli::processBatch(const QStringList& inputs, const QString& output, const ProjectSettings& settings, int jobs) {
+    QString pattern = outputPattern(output);
+    if (pattern.isEmpty()) {
+        print(stderr, "Error: With several inputs --output must be a directory or a pattern containing {name}.");
+        return 1;
+    }
+
+    QStringList missing;
+    QStringList files = expandInputs(inputs, &missing);
+    for (const QString& path : missing) {
+        print(stderr, QString("Error: No input found: %1").arg(path));
+        if (s_stats) {
+            s_stats->addStatus(path, QString(), "error", "No input found");
+        }
+    }
+
+    QList<Task> tasks;
+    QSet<QString> outputs;
+    int failed = missing.size();
+    for (const QString& path : files) {
+        QString outputPath = outputPathFor(path, pattern);
+        if (ImageWriter::formatForPath(outputPath).isEmpty()) {
+            print(stderr, QString("Error: Unsupported export format: %1").arg(outputPath));
+            if (s_stats) {
+                s_stats->addStatus(path, outputPath, "error", "Unsupported export format");
+            }
+            failed++;
+            continue;
+        }
+        if (outputs.contains(outputPath)) {
+            print(stderr, QString("Error: Several inputs would be written to %1").arg(outputPath));
+            if (s_stats) {
+                s_stats->addStatus(path, outputPath, "error", "Another input is written to the same output");
+            }
+            failed++;
+            continue;
+        }
+        outputs.insert(outputPath);
+        tasks.append({ path, outputPath });
+    }
+
+    Summary summary = processFiles(tasks, settings, jobs);
+    failed += summary.failed;
+    if (tasks.size() + failed > 1) {
+        print(s_status, QString("Processed %1 files: %2 saved, %3 unchanged, %4 failed.")
+            .arg(tasks.size()).arg(summary.saved).arg(summary.unchanged).arg(failed));
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+Cli::Summary Cli::processFiles(const QList<Task>& tasks, const ProjectSettings& settings, int jobs,
+                               const std::function<void(const Task&)>& exported) {
+    Summary summary;
+    if (tasks.isEmpty()) {
+        return summary;
+    }
+
+    // The same pipeline as Export All in the GUI. The decoded images live in
+    // the worker, at most a few files per thread at a time.
+    ProcessingWorker worker;
+    if (jobs > 0) {
+        worker.setMaxThreadCount(jobs);
+    }
+    worker.setDiskCache(s_diskCache);
+    QObject::connect(&worker, &ProcessingWorker::fileProcessed, [&](const ProcessingResult& result) {
+        const Task& task = tasks[int(result.fileId - 1)];
+        if (s_stats) {
+            s_stats->addResult(task.inputPath, task.outputPath, result, settings);
+        }
+        if (!result.error.isEmpty()) {
+            print(stderr, "Error: " + result.error);
+            summary.failed++;
+            return;
+        }
+        switch (result.exportResult) {
+        case ImageWriter::Result::Failed:
+            print(stderr, QString("Error: Could not save image: %1").arg(task.outputPath));
+            summary.failed++;
+            return;
+        case ImageWriter::Result::Skipped:
+            print(s_status, QString("Unchanged: %1").arg(task.outputPath));
+            summary.unchanged++;
+            break;
+        case ImageWriter::Result::Written:
+            print(s_status, QString("Saved: %1").arg(task.outputPath));
+            summary.saved++;
+            break;
+        }
+        if (exported) {
+            exported(task);
+        }
+    });
+
+    // Results are delivered through queued calls, so wait in an event loop
+    QEventLoop loop;
+    QObject::connect(&worker, &ProcessingWorker::finished, &loop, &QEventLoop::quit);
+    for (int i = 0; i < tasks.size(); i++) {
+        ProcessingJob job;
+        job.fileId = quint64(i + 1);
+        job.sourcePath = tasks[i].inputPath;
+        job.settings = settings;
+        job.exportPath = tasks[i].outputPath;
+        job.keepImage = false;
+        worker.submit(job);
+    }
+    loop.exec();
+    return summary;
+}
+
+QStringList Cli::expandInputs(const QStringList& inputs, QStringList* missing) {
+    QStringList nameFilters;
+    for (const QByteArray& format : QImageReader::supportedImageFormats()) {
+        nameFilters.append("*." + QString::fromLatin1(format));
+    }
+
+    // Earlier exports in the same directory are not inputs
+    auto isExport = [](const QString& name) {
+        return QFileInfo(name).completeBaseName().endsWith(".export");
+    };
+
+    QStringList result;
+    for (const QString& input : inputs) {
+        QFileInfo info(input);
+        QStringList found;
+        if (info.isDir()) {
+            QDir dir(input);
+            for (const QString& name : dir.entryList(nameFilters, QDir::Files, QDir::Name)) {
+                if (!isExport(name)) {
+                    found.append(dir.filePath(name));
+                }
+            }
+        } else if (info.fileName().contains(QRegularExpression("[*?\\[]"))) {
+            // Wildcards in the file name, for shells that don't expand them
+            QDir dir = info.dir();
+            for (const QString& name : dir.entryList(QStringList(info.fileName()), QDir::Files, QDir::Name)) {
+                if (!isExport(name)) {
+                    found.append(dir.filePath(name));
+                }
+            }
+        } else if (info.isFile()) {
+            found.append(input);
+        }
+        if (found.isEmpty()) {
+            missing->append(input);
+        }
+        result += found;
+    }
+    result.removeDuplicates();
+    return result;
+}
+
+QString Cli::outputPattern(const QString& output) {
+    if (output.isEmpty()) {
+        return DefaultOutputPattern;
+    }
+    if (QFileInfo(output).isDir()) {
+        return QDir(output).filePath("{name}.export.{ext}");
+    }
+    return output.contains("{name}") ? output : QString();
+}
+
+QString Cli::outputPathFor(const QString& inputPath, const QString& pattern) {
+    QFileInfo info(inputPath);
+    QString result = pattern;
+    result.replace("{dir}", info.absolutePath());
+    result.replace("{name}", info.completeBaseName());
+    // Inputs that can be read but not written (bmp, gif, ...) are exported as PNG
+    QString suffix = info.suffix();
+    if (ImageWriter::formatForName(suffix).isEmpty()) {
+        suffix = "png";
+    }
+    result.replace("{ext}", suffix);
+    return result;
+}
@@ -0,0 +1,65 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+#include <functional>
+
+#include "project.h"
+#include "diskcache.h"
+#include "runstats.h"
+
+// Headless mode, used when TilePad is started with command line flags. Runs
+// on a QCoreApplication: no platform plugin, no display needed. Returns the
+// process exit code.
+class Cli
+{
+public:
+    static int run(QCoreApplication& app);
+
+    // Replaces {dir}, {name} and {ext} in the pattern with the parts of the input path
+    static QString outputPathFor(const QString& inputPath, const QString& pattern);
+
+private:
+    struct Task {
+        QString inputPath;
+        QString outputPath;
+        qint64 sourceModified = 0;
+    };
+
+    struct Summary {
+        int saved = 0;
+        int unchanged = 0;
+        int failed = 0;
+    };
+
+    // "-" as the input or output path streams the encoded image through stdin or stdout
+    static int processImage(const QString& inputPath, const QString& outputPath, const QString& format,
+                            const ProjectSettings& settings);
+
+    // Many inputs in one process, outputs named by a {dir}/{name}/{ext} pattern
+    static int processBatch(const QStringList& inputs, const QString& output, const ProjectSettings& settings, int jobs);
+
+    // Processes every file of a project whose export is missing or out of date
+    static int buildProject(const QString& projectPath, int jobs);
+
+    // Runs the tasks in parallel and prints one line per file
+    static Summary processFiles(const QList<Task>& tasks, const ProjectSettings& settings, int jobs,
+                                const std::function<void(const Task&)>& exported = nullptr);
+
+    static QStringList expandInputs(const QStringList& inputs, QStringList* missing);
+
+    // The -o value as an output pattern, empty if it can't name several files
+    static QString outputPattern(const QString& output);
+
+    // Finished exports shared between runs, null with --no-cache
+    static DiskCache* s_diskCache;
+
+    // Statistics of the run, null without --stats
+    static RunStats* s_stats;
+};
+
+#endif // CLI_H
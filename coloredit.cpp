@@ -57,7 +57,10 @@ void ColorEdit::setColorText(QString value) {
     }
     box->setStyleSheet("background-color: #" + text + ";");
     edit->setText(text);
-    color = newColor;
+    if (newColor != color) {
+        color = newColor;
+        emit colorChanged(color);
+    }
 }
 
 QColor ColorEdit::getColor() {
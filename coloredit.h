@@ -14,6 +14,7 @@ public:
     void setColorText(QString text);
 
 signals:
+    void colorChanged(QColor color);
 
 public slots:
     void boxClicked();
@@ -0,0 +1,152 @@
+#include "diskcache.h"
+#include "imagewriter.h"
+#include "tileprocessor.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+// One insert in this many scans the directory, even below the budget
+static const int ScanChance = 64;
+
+DiskCache::DiskCache(const QString& directory, qint64 limitBytes) : m_directory(directory), m_limit(limitBytes) {
+}
+
+QString DiskCache::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/TilePad/results";
+}
+
+QString DiskCache::directory() const {
+    return m_directory;
+}
+
+qint64 DiskCache::limit() const {
+    return m_limit;
+}
+
+QByteArray DiskCache::key(const QByteArray& sourceData, const ProjectSettings& settings, const QString& format) {
+    // Results of other padding algorithms or TilePad versions (encoder
+    // changes) never match
+    QByteArray material = ImageWriter::hash(sourceData);
+    material += TileProcessor::settingsKey(settings);
+    material += format.toUpper().toLatin1() + '\0';
+    material += QByteArray::number(TileProcessor::AlgorithmVersion) + '\0';
+    material += QCoreApplication::applicationVersion().toLatin1();
+    return ImageWriter::hash(material).toHex();
+}
+
+QString DiskCache::pathFor(const QByteArray& key) const {
+    // Two levels, so no directory gets too many entries
+    return m_directory + "/" + QString::fromLatin1(key.left(2)) + "/" + QString::fromLatin1(key);
+}
+
+bool DiskCache::find(const QByteArray& key, QByteArray* data) const {
+    QFile f(pathFor(key));
+    if (!f.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    *data = f.readAll();
+    touch(f);
+    return !data->isEmpty();
+}
+
+void DiskCache::touch(QFile& file) {
+    // The modification time orders entries for eviction. Setting it on the
+    // read handle needs ownership, setting it to now only write permission,
+    // which is enough for entries other users added to a shared cache.
+    if (file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime)) {
+        return;
+    }
+#ifdef Q_OS_UNIX
+    utimensat(AT_FDCWD, QFile::encodeName(file.fileName()).constData(), nullptr, 0);
+#else
+    QFile writable(file.fileName());
+    if (writable.open(QIODevice::ReadWrite | QIODevice::ExistingOnly)) {
+        writable.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+#endif
+}
+
+void DiskCache::insert(const QByteArray& key, const QByteArray& data) {
+    QString path = pathFor(key);
+    if (data.isEmpty() || QFileInfo::exists(path)) {
+        return;
+    }
+    QDir().mkpath(QFileInfo(path).path());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly) || f.write(data) != data.size() || !f.commit()) {
+        return;
+    }
+    // Other users of a shared cache can then touch the entry too
+    QFile::setPermissions(path, QFile::permissions(path) | QFileDevice::WriteGroup);
+
+    QMutexLocker locker(&m_mutex);
+    m_added += data.size();
+    // Every process scans now and then, so many short runs together still trim
+    if (m_added > m_limit / 10 || QRandomGenerator::global()->bounded(ScanChance) == 0) {
+        trim();
+    }
+}
+
+qint64 DiskCache::totalBytes() const {
+    qint64 total = 0;
+    QDirIterator it(m_directory, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        total += it.fileInfo().size();
+    }
+    return total;
+}
+
+void DiskCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    QDir(m_directory).removeRecursively();
+    m_added = 0;
+}
+
+void DiskCache::trim() {
+    struct Entry {
+        QString path;
+        qint64 size;
+        QDateTime used;
+    };
+    m_added = 0;
+    QList<Entry> entries;
+    qint64 total = 0;
+    QDirIterator it(m_directory, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        entries.append({ info.filePath(), info.size(), info.lastModified() });
+        total += info.size();
+    }
+    if (total <= m_limit) {
+        return;
+    }
+
+    // Down to 90% of the limit, so not every insert has to scan the directory
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    qint64 target = m_limit / 10 * 9;
+    for (const Entry& entry : entries) {
+        if (total <= target) {
+            break;
+        }
+        if (QFile::remove(entry.path)) {
+            total -= entry.size;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QFile>
+
+#include "projectsettings.h"
+
+// Finished exports on disk, addressed by the bytes of the source file, the
+// settings, the output format, the padding algorithm and the TilePad version. A hit skips decoding,
+// padding and encoding. The directory can be shared by several checkouts or
+// machines: entries are written atomically and never modified afterwards.
+// When the directory grows over the limit, the least recently used entries
+// are deleted. The directory is only scanned for that after a process added a
+// tenth of the limit, or now and then, so short CLI runs on a large share
+// don't pay for it. Safe to use from several threads.
+class DiskCache
+{
+public:
+    static constexpr qint64 DefaultLimitMB = 1024;
+
+    DiskCache(const QString& directory, qint64 limitBytes);
+
+    // Shared by the GUI and the CLI
+    static QString defaultDirectory();
+
+    QString directory() const;
+    qint64 limit() const;
+
+    static QByteArray key(const QByteArray& sourceData, const ProjectSettings& settings, const QString& format);
+
+    bool find(const QByteArray& key, QByteArray* data) const;
+    void insert(const QByteArray& key, const QByteArray& data);
+
+    // Size of the entries on disk now, also the ones other processes added. Scans the directory.
+    qint64 totalBytes() const;
+
+    // Deletes every entry
+    void clear();
+
+private:
+    QString pathFor(const QByteArray& key) const;
+    static void touch(QFile& file);
+    void trim();
+
+    QString m_directory;
+    qint64 m_limit;
+    mutable QMutex m_mutex;
+    qint64 m_added = 0; // Bytes this process inserted since the last scan
+};
+
+#endif // DISKCACHE_H
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Pads a generated tileset through libtilepad with ctypes.
+
+Usage: pad_ctypes.py [path/to/libtilepad.so] [output.png]
+
+Builds a 4x3 sheet of 16x16 tiles in memory, pads it once on the calling
+thread and once on the library's thread pool, checks that both results are
+equal, prints the layout and the position of every tile and writes the padded
+sheet as a PNG. The band threshold is lowered, so the pool renders the small
+sheet in concurrent bands like a large one. Only the standard library is needed.
+The exit code is 1 if anything fails, ctest runs it as the c_api_example test.
+"""
+
+import ctypes
+import os
+import struct
+import sys
+import zlib
+
+TILEPAD_ABI_VERSION = 1
+TILEPAD_FORMAT_RGBA8888 = 2
+TILEPAD_OK = 0
+
+
+class Options(ctypes.Structure):
+    _fields_ = [
+        ("tile_width", ctypes.c_int),
+        ("tile_height", ctypes.c_int),
+        ("padding", ctypes.c_int),
+        ("force_pot", ctypes.c_int),
+        ("reorder", ctypes.c_int),
+        ("transparent", ctypes.c_int),
+        ("background_color", ctypes.c_uint32),
+        ("remove_padding", ctypes.c_int),
+    ]
+
+
+class Layout(ctypes.Structure):
+    _fields_ = [
+        ("cols", ctypes.c_int),
+        ("rows", ctypes.c_int),
+        ("grid_width", ctypes.c_int),
+        ("grid_height", ctypes.c_int),
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("tiles_per_row", ctypes.c_int),
+        ("band_rows", ctypes.c_int),
+    ]
+
+
+def load(path):
+    lib = ctypes.CDLL(path)
+    job = ctypes.c_void_p
+    lib.tilepad_abi_version.restype = ctypes.c_int
+    lib.tilepad_status_text.argtypes = [ctypes.c_int]
+    lib.tilepad_status_text.restype = ctypes.c_char_p
+    lib.tilepad_default_options.argtypes = [ctypes.POINTER(Options)]
+    lib.tilepad_default_options.restype = None
+    lib.tilepad_set_thread_count.argtypes = [ctypes.c_int]
+    lib.tilepad_set_thread_count.restype = None
+    lib.tilepad_set_band_threshold.argtypes = [ctypes.c_int64]
+    lib.tilepad_set_band_threshold.restype = None
+    lib.tilepad_job_create.argtypes = [ctypes.POINTER(Options)]
+    lib.tilepad_job_create.restype = job
+    lib.tilepad_job_destroy.argtypes = [job]
+    lib.tilepad_job_destroy.restype = None
+    buffer_args = [job, ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_ssize_t, ctypes.c_int]
+    lib.tilepad_job_set_source.argtypes = buffer_args
+    lib.tilepad_job_set_target.argtypes = buffer_args
+    lib.tilepad_job_layout.argtypes = [job, ctypes.POINTER(Layout)]
+    lib.tilepad_job_tile_position.argtypes = [job, ctypes.c_int, ctypes.POINTER(ctypes.c_int),
+                                              ctypes.POINTER(ctypes.c_int)]
+    for name in ("tilepad_job_run", "tilepad_job_start", "tilepad_job_wait"):
+        getattr(lib, name).argtypes = [job]
+    if lib.tilepad_abi_version() != TILEPAD_ABI_VERSION:
+        sys.exit("libtilepad has ABI version %d, expected %d" % (lib.tilepad_abi_version(), TILEPAD_ABI_VERSION))
+    return lib
+
+
+def check(lib, status):
+    if status != TILEPAD_OK:
+        sys.exit("libtilepad: " + lib.tilepad_status_text(status).decode())
+
+
+def make_tileset(cols, rows, size):
+    """RGBA8888 rows, every tile a flat color with a darker diagonal"""
+    data = bytearray(cols * size * rows * size * 4)
+    stride = cols * size * 4
+    for ty in range(rows):
+        for tx in range(cols):
+            r, g, b = (tx * 60 + 40) % 256, (ty * 80 + 60) % 256, ((tx + ty) * 50) % 256
+            for y in range(size):
+                for x in range(size):
+                    shade = 2 if x == y else 1
+                    offset = (ty * size + y) * stride + (tx * size + x) * 4
+                    data[offset:offset + 4] = bytes((r // shade, g // shade, b // shade, 255))
+    return data
+
+
+def write_png(path, data, width, height):
+    rows = b"".join(b"\0" + bytes(data[y * width * 4:(y + 1) * width * 4]) for y in range(height))
+
+    def chunk(kind, body):
+        return struct.pack(">I", len(body)) + kind + body + struct.pack(">I", zlib.crc32(kind + body))
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 6, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(rows)))
+        f.write(chunk(b"IEND", b""))
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.getcwd(), "libtilepad.so")
+    output = sys.argv[2] if len(sys.argv) > 2 else "padded.png"
+    lib = load(path)
+    # Split every target into bands, over several threads even on a single core
+    lib.tilepad_set_band_threshold(1)
+    lib.tilepad_set_thread_count(4)
+
+    cols, rows, size = 4, 3, 16
+    source = make_tileset(cols, rows, size)
+    width, height = cols * size, rows * size
+    # from_buffer shares the bytearray's memory with the library, nothing is copied
+    source_ptr = ctypes.addressof((ctypes.c_char * len(source)).from_buffer(source))
+
+    options = Options()
+    lib.tilepad_default_options(ctypes.byref(options))
+    options.tile_width = options.tile_height = size
+    options.padding = 2
+    options.force_pot = 1
+    options.reorder = 1
+
+    job = lib.tilepad_job_create(ctypes.byref(options))
+    if not job:
+        sys.exit("Invalid options")
+    try:
+        check(lib, lib.tilepad_job_set_source(job, source_ptr, width, height, width * 4, TILEPAD_FORMAT_RGBA8888))
+        layout = Layout()
+        check(lib, lib.tilepad_job_layout(job, ctypes.byref(layout)))
+        print("Layout: %dx%d tiles, target %dx%d, %d tiles per row, grid %dx%d" % (
+            layout.cols, layout.rows, layout.width, layout.height, layout.tiles_per_row,
+            layout.grid_width, layout.grid_height))
+        if layout.band_rows < 2:
+            sys.exit("The layout has %d band rows, the pool can't split it" % layout.band_rows)
+        x, y = ctypes.c_int(), ctypes.c_int()
+        for index in range(layout.cols * layout.rows):
+            check(lib, lib.tilepad_job_tile_position(job, index, ctypes.byref(x), ctypes.byref(y)))
+            print("  tile %2d at %d,%d" % (index, x.value, y.value))
+
+        results = []
+        for run_on_pool in (False, True):
+            # Filled with garbage, every pixel must be written by both paths
+            target = bytearray(b"\x5a" * (layout.width * layout.height * 4))
+            target_ptr = ctypes.addressof((ctypes.c_char * len(target)).from_buffer(target))
+            check(lib, lib.tilepad_job_set_target(job, target_ptr, layout.width, layout.height, layout.width * 4,
+                                                  TILEPAD_FORMAT_RGBA8888))
+            if run_on_pool:
+                check(lib, lib.tilepad_job_start(job))
+                check(lib, lib.tilepad_job_wait(job))
+            else:
+                check(lib, lib.tilepad_job_run(job))
+            results.append(target)
+        if results[0] != results[1]:
+            sys.exit("The results of tilepad_job_run() and tilepad_job_start() differ")
+    finally:
+        lib.tilepad_job_destroy(job)
+
+    write_png(output, results[0], layout.width, layout.height)
+    print("Wrote " + output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+#include "imagecache.h"
+
+void ImageCache::setBudget(qint64 bytes) {
+    m_budget = bytes;
+}
+
+qint64 ImageCache::budget() const {
+    return m_budget;
+}
+
+qint64 ImageCache::totalBytes() const {
+    return m_total;
+}
+
+void ImageCache::touch(quint64 id, qint64 bytes) {
+    remove(id);
+    if (bytes <= 0) {
+        return;
+    }
+    m_order.append(id);
+    m_bytes[id] = bytes;
+    m_total += bytes;
+}
+
+void ImageCache::remove(quint64 id) {
+    auto it = m_bytes.find(id);
+    if (it == m_bytes.end()) {
+        return;
+    }
+    m_total -= it.value();
+    m_bytes.erase(it);
+    m_order.removeOne(id);
+}
+
+void ImageCache::clear() {
+    m_order.clear();
+    m_bytes.clear();
+    m_total = 0;
+}
+
+QList<quint64> ImageCache::evictionCandidates(quint64 keepId) const {
+    QList<quint64> result;
+    qint64 total = m_total;
+    for (quint64 id : m_order) {
+        if (total <= m_budget) {
+            break;
+        }
+        if (id == keepId) {
+            continue;
+        }
+        result.append(id);
+        total -= m_bytes.value(id);
+    }
+    return result;
+}
+
+qint64 ImageCache::pixmapBytes(const QPixmap& pixmap) {
+    return qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
@@ -0,0 +1,36 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QList>
+#include <QHash>
+#include <QPixmap>
+
+// Least-recently-used bookkeeping of the decoded images held per file. The
+// images themselves stay in the FileEntry, the cache decides which files
+// have to give them up when the memory budget is exceeded.
+class ImageCache
+{
+public:
+    static constexpr qint64 DefaultBudgetMB = 1024;
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 totalBytes() const;
+
+    void touch(quint64 id, qint64 bytes);
+    void remove(quint64 id);
+    void clear();
+
+    // Least recently used first, enough of them to get back under the budget
+    QList<quint64> evictionCandidates(quint64 keepId) const;
+
+    static qint64 pixmapBytes(const QPixmap& pixmap);
+
+private:
+    qint64 m_budget = DefaultBudgetMB * 1024 * 1024;
+    qint64 m_total = 0;
+    QList<quint64> m_order; // Least recently used first
+    QHash<quint64, qint64> m_bytes;
+};
+
+#endif // IMAGECACHE_H
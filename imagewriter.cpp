@@ -0,0 +1,87 @@
+#include "imagewriter.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QCryptographicHash>
+
+QString ImageWriter::formatForPath(const QString& path) {
+    return formatForName(QFileInfo(path).suffix());
+}
+
+QString ImageWriter::formatForName(const QString& name) {
+    QString format = name.toUpper();
+    if (format == "JPEG") {
+        format = "JPG";
+    }
+    if (format != "PNG" && format != "JPG") {
+        return QString();
+    }
+    return format;
+}
+
+QByteArray ImageWriter::hash(const QByteArray& data) {
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+ImageWriter::Result ImageWriter::write(const QImage& image, const QString& path, const QString& format, ExportStamp* stamp) {
+    QByteArray data = encode(image, format);
+    if (data.isEmpty()) {
+        return Result::Failed;
+    }
+    return writeData(data, path, stamp);
+}
+
+QByteArray ImageWriter::encode(const QImage& image, const QString& format) {
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, format.toStdString().c_str())) {
+        return QByteArray();
+    }
+    return data;
+}
+
+ImageWriter::Result ImageWriter::writeData(const QByteArray& data, const QString& path, ExportStamp* stamp) {
+    QByteArray dataHash = hash(data);
+
+    // Only files with the same size can be identical; the stamp saves reading
+    // the file back when it hasn't been touched since the last write.
+    QFileInfo info(path);
+    if (info.exists() && info.size() == data.size()) {
+        bool identical = false;
+        if (stamp && stamp->hash == dataHash && stamp->size == info.size() && stamp->modified == info.lastModified()) {
+            identical = true;
+        } else {
+            QFile existing(path);
+            if (existing.open(QIODevice::ReadOnly)) {
+                identical = hash(existing.readAll()) == dataHash;
+            }
+        }
+        if (identical) {
+            if (stamp) {
+                stamp->hash = dataHash;
+                stamp->size = info.size();
+                stamp->modified = info.lastModified();
+            }
+            return Result::Skipped;
+        }
+    }
+
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return Result::Failed;
+    }
+    if (f.write(data) != data.size()) {
+        return Result::Failed;
+    }
+    f.close();
+
+    if (stamp) {
+        info.refresh();
+        stamp->hash = dataHash;
+        stamp->size = info.size();
+        stamp->modified = info.lastModified();
+    }
+    return Result::Written;
+}
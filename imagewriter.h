@@ -0,0 +1,39 @@
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+
+// Remembers what was last written to an export path, so an unchanged
+// file can be recognized without reading it back.
+struct ExportStamp {
+    QByteArray hash;
+    qint64 size = -1;
+    QDateTime modified;
+};
+
+class ImageWriter
+{
+public:
+    enum class Result { Written, Skipped, Failed };
+
+    // Returns "PNG" or "JPG" for a supported export path, otherwise an empty string.
+    static QString formatForPath(const QString& path);
+
+    // The same for a format name like "png" or "jpeg"
+    static QString formatForName(const QString& name);
+
+    // Encodes the image and writes it only if the bytes differ from the existing file.
+    static Result write(const QImage& image, const QString& path, const QString& format, ExportStamp* stamp = nullptr);
+
+    // The two halves of write(), for callers that keep the encoded bytes. encode()
+    // returns an empty array on failure.
+    static QByteArray encode(const QImage& image, const QString& format);
+    static Result writeData(const QByteArray& data, const QString& path, ExportStamp* stamp = nullptr);
+
+    static QByteArray hash(const QByteArray& data);
+};
+
+#endif // IMAGEWRITER_H
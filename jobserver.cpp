@@ -0,0 +1,200 @@
+#include "jobserver.h"
+#include "project.h"
+#include "tileprocessor.h"
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// The stdin reader blocks in getline() and can't be stopped, it is left
+// running when the server quits. It only posts lines while the server exists.
+static QMutex s_readerMutex;
+static JobServer* s_server = nullptr;
+
+JobServer::JobServer(const ProjectSettings& defaults, int jobs, QObject* parent)
+    : QObject(parent), m_defaults(defaults) {
+    if (jobs > 0) {
+        m_worker.setMaxThreadCount(jobs);
+    }
+    connect(&m_worker, &ProcessingWorker::fileProcessed, this, &JobServer::fileProcessed);
+}
+
+JobServer::~JobServer() {
+    QMutexLocker locker(&s_readerMutex);
+    s_server = nullptr;
+}
+
+void JobServer::setDiskCache(DiskCache* cache) {
+    m_worker.setDiskCache(cache);
+}
+
+int JobServer::run() {
+    {
+        QMutexLocker locker(&s_readerMutex);
+        s_server = this;
+    }
+    std::thread([]() {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            QByteArray data = QByteArray::fromStdString(line);
+            QMutexLocker locker(&s_readerMutex);
+            if (!s_server) {
+                return;
+            }
+            JobServer* server = s_server;
+            QMetaObject::invokeMethod(server, [server, data]() { server->handleLine(data); }, Qt::QueuedConnection);
+        }
+        QMutexLocker locker(&s_readerMutex);
+        if (s_server) {
+            JobServer* server = s_server;
+            QMetaObject::invokeMethod(server, [server]() { server->inputClosed(); }, Qt::QueuedConnection);
+        }
+    }).detach();
+
+    m_loop.exec();
+    return 0;
+}
+
+void JobServer::handleLine(const QByteArray& line) {
+    if (line.trimmed().isEmpty()) {
+        return;
+    }
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (!doc.isObject()) {
+        replyError(QJsonValue(), "Invalid JSON: " + parseError.errorString());
+        return;
+    }
+    QJsonObject request = doc.object();
+    QJsonValue id = request["id"];
+    if (m_closing) {
+        // Every request is answered, also the ones after a quit
+        replyError(id, "Server is shutting down");
+        return;
+    }
+
+    QString command = request["command"].toString();
+    if (command == "quit") {
+        m_closing = true;
+        quitWhenIdle();
+        return;
+    }
+    if (command == "ping") {
+        QJsonObject message;
+        message["id"] = id;
+        message["status"] = "ok";
+        reply(message);
+        return;
+    }
+    if (!command.isEmpty()) {
+        replyError(id, "Unknown command: " + command);
+        return;
+    }
+
+    QString input = request["input"].toString();
+    QString output = request["output"].toString();
+    if (input.isEmpty() || output.isEmpty()) {
+        replyError(id, "Both input and output are required.");
+        return;
+    }
+    if (ImageWriter::formatForPath(output).isEmpty()) {
+        replyError(id, "Unsupported export format: " + output);
+        return;
+    }
+
+    // Two jobs writing the same file at once could leave it torn
+    QString outputPath = QFileInfo(output).absoluteFilePath();
+    for (const Request& other : m_requests) {
+        if (QFileInfo(other.output).absoluteFilePath() == outputPath) {
+            replyError(id, "Output is already being written by a pending request: " + output);
+            return;
+        }
+    }
+
+    ProjectSettings settings = Project::settingsFromJson(request["settings"].toObject(), m_defaults);
+    if (!TileProcessor::isValid(settings)) {
+        replyError(id, QString("Invalid settings: tile sizes must be from 1 to %1 and the padding from 0 to %1.")
+                           .arg(PaddingEngine::MaxTileSize));
+        return;
+    }
+
+    Request& pending = m_requests[m_nextFileId];
+    pending.id = id;
+    pending.input = input;
+    pending.output = output;
+    pending.timer.start();
+
+    ProcessingJob job;
+    job.fileId = m_nextFileId++;
+    job.sourcePath = input;
+    job.settings = settings;
+    job.exportPath = output;
+    job.keepImage = false;
+    m_worker.submit(job);
+}
+
+void JobServer::inputClosed() {
+    // Jobs already submitted are still answered
+    m_closing = true;
+    quitWhenIdle();
+}
+
+void JobServer::fileProcessed(const ProcessingResult& result) {
+    auto it = m_requests.find(result.fileId);
+    if (it == m_requests.end()) {
+        return;
+    }
+    const Request& request = it.value();
+
+    QJsonObject message;
+    message["id"] = request.id;
+    message["input"] = request.input;
+    message["output"] = request.output;
+    if (!result.error.isEmpty()) {
+        message["status"] = "error";
+        message["error"] = result.error;
+    } else if (result.exportResult == ImageWriter::Result::Failed) {
+        message["status"] = "error";
+        message["error"] = "Could not save image: " + request.output;
+    } else {
+        message["status"] = result.exportResult == ImageWriter::Result::Skipped ? "unchanged" : "saved";
+        message["cached"] = result.cached;
+    }
+
+    QJsonObject timings;
+    timings["decodeMs"] = result.decodeMs;
+    timings["padMs"] = result.padMs;
+    timings["encodeMs"] = result.encodeMs;
+    timings["totalMs"] = request.timer.nsecsElapsed() / 1000000.0; // Includes waiting in the queue
+    message["timings"] = timings;
+
+    m_requests.erase(it);
+    reply(message);
+    quitWhenIdle();
+}
+
+void JobServer::reply(const QJsonObject& message) {
+    QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact) + "\n";
+    fwrite(line.constData(), 1, size_t(line.size()), stdout);
+    fflush(stdout);
+}
+
+void JobServer::replyError(const QJsonValue& id, const QString& error) {
+    QJsonObject message;
+    message["id"] = id;
+    message["status"] = "error";
+    message["error"] = error;
+    reply(message);
+}
+
+void JobServer::quitWhenIdle() {
+    if (m_closing && m_requests.isEmpty()) {
+        m_loop.quit();
+    }
+}
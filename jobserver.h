@@ -0,0 +1,59 @@
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonValue>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QEventLoop>
+
+#include "processingworker.h"
+
+// Serves padding jobs over stdin/stdout, one JSON object per line, so build
+// tools can keep one warm process instead of starting TilePad per file.
+//
+//   {"id": 1, "input": "a.png", "output": "a.export.png", "settings": {"padding": 2}}
+//   {"id": 2, "command": "ping"}
+//   {"command": "quit"}
+//
+// Settings use the names of the project file, missing ones come from the
+// command line. Every request gets one reply line with its id, a status and
+// the timings of the stages. Replies arrive in completion order.
+class JobServer : public QObject
+{
+    Q_OBJECT
+public:
+    JobServer(const ProjectSettings& defaults, int jobs, QObject* parent = nullptr);
+    ~JobServer() override;
+
+    // Finished exports are looked up and stored here, may be null
+    void setDiskCache(DiskCache* cache);
+
+    // Serves until stdin is closed or a quit command arrives, returns the exit code
+    int run();
+
+private:
+    struct Request {
+        QJsonValue id;
+        QString input;
+        QString output;
+        QElapsedTimer timer;
+    };
+
+    void handleLine(const QByteArray& line);
+    void inputClosed();
+    void fileProcessed(const ProcessingResult& result);
+    void reply(const QJsonObject& message);
+    void replyError(const QJsonValue& id, const QString& error);
+    void quitWhenIdle();
+
+    ProjectSettings m_defaults;
+    ProcessingWorker m_worker;
+    QHash<quint64, Request> m_requests;
+    quint64 m_nextFileId = 1;
+    bool m_closing = false;
+    QEventLoop m_loop;
+};
+
+#endif // JOBSERVER_H
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "trace.h"
 
 #include <QWidget>
 #include <QHBoxLayout>
@@ -7,13 +8,14 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QFileDialog>
-#include <QBuffer>
 #include <QCoreApplication>
 #include <QSettings>
 #include <QStyle>
 #include <QEvent>
 #include <QMessageBox>
 #include <QToolButton>
+#include <QImageReader>
+#include <QInputDialog>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -21,6 +23,20 @@
 #include <windowsx.h>
 #endif
 
+// Milliseconds without further settings edits before the live preview reprocesses,
+// about two frames: enough to merge the steps of a held spin box arrow
+static const int LivePreviewDelay = 30;
+
+// Milliseconds without further change events before changed sources are reloaded
+static const int WatchDelay = 300;
+
+// Milliseconds between updates of the memory status
+static const int MemoryStatusInterval = 1000;
+
+// How many times a vanished source is looked for again, editors saving by rename
+// remove the file for a moment
+static const int WatchRetries = 10;
+
 MainWindow::MainWindow(ThemeManager* themeManager, Project* project, QWidget *parent)
     : QMainWindow(parent), m_themeManager(themeManager), m_project(project)
 {
@@ -30,6 +46,15 @@ MainWindow::MainWindow(ThemeManager* themeManager, Project* project, QWidget *pa
 
     fileWatcher = new QFileSystemWatcher(this);
     connect(fileWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::sourceFileChanged);
+    m_watchTimer = new QTimer(this);
+    m_watchTimer->setSingleShot(true);
+    m_watchTimer->setInterval(WatchDelay);
+    connect(m_watchTimer, &QTimer::timeout, this, &MainWindow::reloadChangedFiles);
+
+    m_worker = new ProcessingWorker(this);
+    connect(m_worker, &ProcessingWorker::fileProcessed, this, &MainWindow::fileProcessed);
+    connect(m_worker, &ProcessingWorker::finished, this, &MainWindow::processingFinished);
+    connect(m_worker, &ProcessingWorker::bandProcessed, this, &MainWindow::bandProcessed);
 
     m_titleBar = new TitleBar(this);
     setupFileMenu();
@@ -45,7 +70,8 @@ MainWindow::MainWindow(ThemeManager* themeManager, Project* project, QWidget *pa
     for (int i = 0; i < m_project->fileCount(); i++) {
         auto& entry = m_project->fileAt(i);
         if (!entry.sourcePath.isEmpty()) {
-            entry.sourcePixmap.load(entry.sourcePath);
+            // Decoded lazily, when the tab is activated or the file is processed
+            entry.sourceSize = QImageReader(entry.sourcePath).size();
             QFileInfo info(entry.sourcePath);
             m_fileTabBar->addTab(info.fileName());
         }
@@ -53,6 +79,7 @@ MainWindow::MainWindow(ThemeManager* themeManager, Project* project, QWidget *pa
     if (m_project->fileCount() > 0) {
         switchToFile(0);
     }
+    updateWatchedFiles();
 
     updateWindowTitle();
 
@@ -65,6 +92,8 @@ MainWindow::MainWindow(ThemeManager* themeManager, Project* project, QWidget *pa
 }
 
 MainWindow::~MainWindow() {
+    // Running stages may still use the disk cache, which is destroyed with the members
+    delete m_worker;
 }
 
 QSize MainWindow::sizeHint() const {
@@ -128,6 +157,13 @@ void MainWindow::setupThemeMenu() {
     themeGroup->addAction(m_darkThemeAction);
     themeGroup->addAction(m_lightThemeAction);
 
+    viewMenu->addSeparator();
+    viewMenu->addAction("Memory Budget...", this, &MainWindow::editImageBudget);
+    viewMenu->addAction("Memory Usage...", this, &MainWindow::showMemoryUsage);
+    m_traceAction = viewMenu->addAction("Record Performance Trace...");
+    m_traceAction->setCheckable(true);
+    connect(m_traceAction, &QAction::toggled, this, &MainWindow::toggleTrace);
+
     connect(m_systemThemeAction, &QAction::triggered, this, [this]() {
         m_themeManager->setThemeMode(ThemeManager::ThemeMode::System);
         m_themeManager->applyTheme();
@@ -243,6 +279,9 @@ void MainWindow::createLayout() {
         removePaddingCheckBox = new QCheckBox("Remove padding");
         connect(removePaddingCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::removePaddingCheckBoxStateChanged);
 
+        livePreviewCheckBox = new QCheckBox("Live preview");
+        livePreviewCheckBox->setToolTip("Reprocess the current file while the settings are edited");
+
         auto addSpinPair = [&](const QString& label, QSpinBox* spin) {
             auto vbox = new QVBoxLayout();
             vbox->setSpacing(4);
@@ -260,6 +299,7 @@ void MainWindow::createLayout() {
         layout->addWidget(reorderCheckBox);
         layout->addWidget(removePaddingCheckBox);
         layout->addStretch();
+        layout->addWidget(livePreviewCheckBox);
     }
 
     // --- Background group ---
@@ -275,7 +315,8 @@ void MainWindow::createLayout() {
         backgroundColorEdit = new ColorEdit();
         backgroundColorEdit->setEnabled(false);
 
-        watchFileCheckBox = new QCheckBox("Watch file");
+        watchFileCheckBox = new QCheckBox("Watch files");
+        watchFileCheckBox->setToolTip("Reprocess and export project files when they change on disk");
         connect(watchFileCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::watchFileCheckBoxStateChanged);
 
         layout->addWidget(transparentCheckBox);
@@ -317,6 +358,10 @@ void MainWindow::createLayout() {
     resultPixmapDropWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     connect(resultPixmapDropWidget, &PixmapDropWidget::filesDropped, this, &MainWindow::importFiles);
 
+    // Source and Result share zoom and pan, so the same spot can be compared
+    connect(sourcePixmapDropWidget, &PixmapDropWidget::viewChanged, resultPixmapDropWidget, &PixmapDropWidget::setView);
+    connect(resultPixmapDropWidget, &PixmapDropWidget::viewChanged, sourcePixmapDropWidget, &PixmapDropWidget::setView);
+
     tabWidget = new QTabWidget();
     tabWidget->addTab(sourcePixmapDropWidget, "Source");
     tabWidget->addTab(resultPixmapDropWidget, "Result");
@@ -379,6 +424,31 @@ void MainWindow::createLayout() {
         fileRow->addWidget(exportButton);
         fileRow->addWidget(exportAllButton);
         groupLayout->addLayout(fileRow);
+
+        // Background processing progress row, only visible while jobs are running
+        m_progressWidget = new QWidget();
+        auto progressRow = new QHBoxLayout(m_progressWidget);
+        progressRow->setContentsMargins(0, 0, 0, 0);
+        progressRow->setSpacing(8);
+
+        m_progressBar = new QProgressBar();
+        m_progressBar->setTextVisible(true);
+
+        m_cancelButton = new QPushButton("Cancel");
+        m_cancelButton->setObjectName("secondaryButton");
+        connect(m_cancelButton, &QPushButton::clicked, m_worker, &ProcessingWorker::cancel);
+
+        progressRow->addWidget(m_progressBar, 1);
+        progressRow->addWidget(m_cancelButton);
+        m_progressWidget->setVisible(false);
+        groupLayout->addWidget(m_progressWidget);
+
+        connect(m_worker, &ProcessingWorker::progressChanged, this, [this](int done, int total) {
+            m_progressBar->setRange(0, total);
+            m_progressBar->setValue(done);
+            m_progressBar->setFormat(QString("Processing %1 / %2").arg(done).arg(total));
+            m_progressWidget->setVisible(total > 0);
+        });
     }
 
     // --- Central assembly ---
@@ -403,9 +473,42 @@ void MainWindow::createLayout() {
     contentLayout->addWidget(tabWidget, 1);
     contentLayout->addWidget(exportGroup);
 
+    // Memory status, opens the details
+    m_memoryButton = new QToolButton();
+    m_memoryButton->setObjectName("memoryButton");
+    m_memoryButton->setAutoRaise(true);
+    m_memoryButton->setToolTip("Memory used by the project. Click for details per file.");
+    connect(m_memoryButton, &QToolButton::clicked, this, &MainWindow::showMemoryUsage);
+    auto statusLayout = new QHBoxLayout();
+    statusLayout->setContentsMargins(0, 0, 0, 0);
+    statusLayout->addStretch(1);
+    statusLayout->addWidget(m_memoryButton);
+    contentLayout->addLayout(statusLayout);
+
     mainLayout->addWidget(contentWidget, 1);
 
     setCentralWidget(centralWidget);
+
+    // Live preview: settings edits restart the timer, the last one reprocesses
+    m_livePreviewTimer = new QTimer(this);
+    m_livePreviewTimer->setSingleShot(true);
+    m_livePreviewTimer->setInterval(LivePreviewDelay);
+    connect(m_livePreviewTimer, &QTimer::timeout, this, &MainWindow::livePreview);
+    connect(tileWidthSpinBox, &QSpinBox::valueChanged, this, &MainWindow::settingsChanged);
+    connect(tileHeightSpinBox, &QSpinBox::valueChanged, this, &MainWindow::settingsChanged);
+    connect(paddingSpinBox, &QSpinBox::valueChanged, this, &MainWindow::settingsChanged);
+    connect(forcePotCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::settingsChanged);
+    connect(reorderCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::settingsChanged);
+    connect(removePaddingCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::settingsChanged);
+    connect(transparentCheckBox, &QCheckBox::checkStateChanged, this, &MainWindow::settingsChanged);
+    connect(backgroundColorEdit, &ColorEdit::colorChanged, this, &MainWindow::settingsChanged);
+
+    // Decoding, processing and eviction all change the numbers, so poll them
+    m_memoryTimer = new QTimer(this);
+    m_memoryTimer->setInterval(MemoryStatusInterval);
+    connect(m_memoryTimer, &QTimer::timeout, this, &MainWindow::updateMemoryStatus);
+    m_memoryTimer->start();
+    updateMemoryStatus();
 }
 
 void MainWindow::loadAppSettings() {
@@ -423,6 +526,21 @@ void MainWindow::loadAppSettings() {
         m_systemThemeAction->setChecked(true);
     }
     m_themeManager->applyTheme();
+
+    qint64 budgetMB = settings.value("imageBudgetMB", ImageCache::DefaultBudgetMB).toLongLong();
+    m_imageCache.setBudget(budgetMB * 1024 * 1024);
+    qint64 resultCacheMB = settings.value("resultCacheMB", ResultCache::DefaultBudgetMB).toLongLong();
+    m_resultCache.setBudget(resultCacheMB * 1024 * 1024);
+
+    // Exports are also kept on disk, across sessions; a limit of 0 disables it
+    QString diskCacheDir = settings.value("diskCacheDir", DiskCache::defaultDirectory()).toString();
+    qint64 diskCacheMB = settings.value("diskCacheMB", DiskCache::DefaultLimitMB).toLongLong();
+    if (diskCacheMB > 0 && !diskCacheDir.isEmpty()) {
+        m_diskCache = std::make_unique<DiskCache>(diskCacheDir, diskCacheMB * 1024 * 1024);
+    }
+    m_worker->setDiskCache(m_diskCache.get());
+
+    livePreviewCheckBox->setChecked(settings.value("livePreview", false).toBool());
 }
 
 void MainWindow::closeEvent(QCloseEvent* event) {
@@ -430,6 +548,8 @@ void MainWindow::closeEvent(QCloseEvent* event) {
         event->ignore();
         return;
     }
+    m_worker->cancel();
+    Trace::stop();
     saveAppSettings();
     QMainWindow::closeEvent(event);
 }
@@ -443,18 +563,148 @@ void MainWindow::saveAppSettings() {
     default:                              themeModeStr = "system"; break;
     }
     settings.setValue("themeMode", themeModeStr);
+    settings.setValue("imageBudgetMB", m_imageCache.budget() / (1024 * 1024));
+    settings.setValue("resultCacheMB", m_resultCache.budget() / (1024 * 1024));
+    settings.setValue("livePreview", livePreviewCheckBox->isChecked());
+}
+
+void MainWindow::editImageBudget() {
+    bool ok = false;
+    int budgetMB = QInputDialog::getInt(this, "Memory Budget",
+        "Memory for decoded images of inactive files (MB):",
+        int(m_imageCache.budget() / (1024 * 1024)), 64, 1024 * 1024, 64, &ok);
+    if (!ok) {
+        return;
+    }
+    m_imageCache.setBudget(qint64(budgetMB) * 1024 * 1024);
+    enforceImageBudget();
+    saveAppSettings();
+}
+
+void MainWindow::toggleTrace(bool enabled) {
+    if (!enabled) {
+        Trace::stop();
+        showInfo("Performance trace saved.");
+        return;
+    }
+    QSettings settings;
+    QString path = QFileDialog::getSaveFileName(this, "Record Performance Trace",
+        settings.value("tracePath", QDir::home().filePath("tilepad-trace.json")).toString(),
+        "Chrome Trace (*.json)");
+    if (path.isEmpty() || !Trace::start(path)) {
+        if (!path.isEmpty()) {
+            showError("Could not write trace: " + path);
+        }
+        QSignalBlocker blocker(m_traceAction);
+        m_traceAction->setChecked(false);
+        return;
+    }
+    settings.setValue("tracePath", path);
+    showInfo("Recording a performance trace until unchecked. Open it in chrome://tracing or ui.perfetto.dev.");
+}
+
+MemoryUsage MainWindow::memoryUsage() const {
+    MemoryUsage usage;
+    for (int i = 0; i < m_project->fileCount(); i++) {
+        const auto& entry = m_project->fileAt(i);
+        MemoryUsage::File file;
+        file.name = entry.sourcePath.isEmpty() ? QString("Untitled %1").arg(i + 1) : QFileInfo(entry.sourcePath).fileName();
+        file.sourceBytes = ImageCache::pixmapBytes(entry.sourcePixmap);
+        file.resultBytes = ImageCache::pixmapBytes(entry.resultPixmap);
+        file.current = i == m_currentFileIndex;
+        file.processing = m_pendingFiles.contains(entry.id);
+        usage.files.append(file);
+    }
+    usage.previewBytes = sourcePixmapDropWidget->previewBytes() + resultPixmapDropWidget->previewBytes();
+    // A file's current result is usually also remembered, it's counted with the file
+    QSet<qint64> filePixmaps;
+    for (int i = 0; i < m_project->fileCount(); i++) {
+        const QPixmap& result = m_project->fileAt(i).resultPixmap;
+        if (!result.isNull()) {
+            filePixmaps.insert(result.cacheKey());
+        }
+    }
+    usage.rememberedBytes = m_resultCache.totalBytes(filePixmaps);
+    usage.processingBytes = m_worker->memoryBytes();
+    return usage;
+}
+
+void MainWindow::updateMemoryStatus() {
+    MemoryUsage usage = memoryUsage();
+    m_memoryButton->setText("Memory: " + MemoryDialog::formatBytes(usage.totalBytes()));
+    if (m_memoryDialog && m_memoryDialog->isVisible()) {
+        m_memoryDialog->setUsage(usage);
+    }
+}
+
+void MainWindow::showMemoryUsage() {
+    if (!m_memoryDialog) {
+        m_memoryDialog = new MemoryDialog(this);
+        connect(m_memoryDialog, &MemoryDialog::purgeInactiveFilesRequested, this, &MainWindow::purgeInactiveFiles);
+        connect(m_memoryDialog, &MemoryDialog::clearRememberedResultsRequested, this, [this]() {
+            m_resultCache.clear();
+            updateMemoryStatus();
+        });
+        connect(m_memoryDialog, &MemoryDialog::clearPreviewsRequested, this, [this]() {
+            sourcePixmapDropWidget->clearPreviews();
+            resultPixmapDropWidget->clearPreviews();
+            updateMemoryStatus();
+        });
+        connect(m_memoryDialog, &MemoryDialog::clearDiskCacheRequested, this, [this]() {
+            if (m_diskCache) {
+                m_diskCache->clear();
+                m_memoryDialog->setDiskCacheBytes(m_diskCache->totalBytes());
+            }
+        });
+    }
+    // The disk cache is scanned once per opening, it isn't polled
+    m_memoryDialog->setDiskCacheBytes(m_diskCache ? m_diskCache->totalBytes() : -1);
+    m_memoryDialog->setUsage(memoryUsage());
+    m_memoryDialog->show();
+    m_memoryDialog->raise();
+    m_memoryDialog->activateWindow();
+}
+
+void MainWindow::purgeInactiveFiles() {
+    // Same as an eviction by the budget, the images come back when the file is needed
+    for (int i = 0; i < m_project->fileCount(); i++) {
+        auto& entry = m_project->fileAt(i);
+        // A source that isn't backed by a file couldn't be decoded again
+        if (i == m_currentFileIndex || m_pendingFiles.contains(entry.id) || entry.sourcePath.isEmpty()) {
+            continue;
+        }
+        m_imageCache.remove(entry.id);
+        // The remembered results would keep the result pixmap alive
+        m_resultCache.removeFile(entry.id);
+        entry.sourcePixmap = QPixmap();
+        entry.resultPixmap = QPixmap();
+    }
+    updateMemoryStatus();
 }
 
 void MainWindow::applyProjectSettingsToUi() {
     const auto& s = m_project->settings();
-    tileWidthSpinBox->setValue(s.tileWidth);
-    tileHeightSpinBox->setValue(s.tileHeight);
-    paddingSpinBox->setValue(s.padding);
-    forcePotCheckBox->setChecked(s.forcePot);
-    reorderCheckBox->setChecked(s.reorder);
-    removePaddingCheckBox->setChecked(s.removePadding);
-    transparentCheckBox->setChecked(s.transparent);
-    backgroundColorEdit->setColorText(s.backgroundColor);
+    {
+        // Loading a project isn't an edit, it must not queue a live preview
+        QSignalBlocker tileWidthBlocker(tileWidthSpinBox);
+        QSignalBlocker tileHeightBlocker(tileHeightSpinBox);
+        QSignalBlocker paddingBlocker(paddingSpinBox);
+        QSignalBlocker forcePotBlocker(forcePotCheckBox);
+        QSignalBlocker reorderBlocker(reorderCheckBox);
+        QSignalBlocker removePaddingBlocker(removePaddingCheckBox);
+        QSignalBlocker transparentBlocker(transparentCheckBox);
+        QSignalBlocker backgroundColorBlocker(backgroundColorEdit);
+        tileWidthSpinBox->setValue(s.tileWidth);
+        tileHeightSpinBox->setValue(s.tileHeight);
+        paddingSpinBox->setValue(s.padding);
+        forcePotCheckBox->setChecked(s.forcePot);
+        reorderCheckBox->setChecked(s.reorder);
+        removePaddingCheckBox->setChecked(s.removePadding);
+        transparentCheckBox->setChecked(s.transparent);
+        backgroundColorEdit->setColorText(s.backgroundColor);
+    }
+    // The blocked signals also enable and disable the dependent widgets
+    removePaddingCheckBoxStateChanged(removePaddingCheckBox->checkState());
     watchFileCheckBox->setChecked(s.watchFile);
     m_exportDirEdit->setText(s.exportDirectory);
 }
@@ -513,14 +763,13 @@ void MainWindow::newProject() {
     if (!promptSaveIfModified()) {
         return;
     }
-
-    // Clear file watcher
-    if (!fileWatcher->files().isEmpty()) {
-        fileWatcher->removePaths(fileWatcher->files());
-    }
+    m_worker->cancel();
 
     m_currentFileIndex = -1;
     m_project->clear();
+    updateWatchedFiles();
+    m_imageCache.clear();
+    m_resultCache.clear();
 
     // Clear file tabs
     while (m_fileTabBar->count() > 0) {
@@ -528,10 +777,8 @@ void MainWindow::newProject() {
     }
 
     // Clear preview
-    sourcePixmapDropWidget->setPixmap(new QPixmap());
-    sourcePixmapDropWidget->update();
-    resultPixmapDropWidget->setPixmap(new QPixmap());
-    resultPixmapDropWidget->update();
+    sourcePixmapDropWidget->setPixmap(QPixmap());
+    resultPixmapDropWidget->setPixmap(QPixmap());
 
     exportEdit->clear();
     reprocessButton->setEnabled(false);
@@ -560,9 +807,7 @@ void MainWindow::openProjectFile(const QString& path) {
     }
 
     // Clear current state
-    if (!fileWatcher->files().isEmpty()) {
-        fileWatcher->removePaths(fileWatcher->files());
-    }
+    m_worker->cancel();
     m_currentFileIndex = -1;
     while (m_fileTabBar->count() > 0) {
         m_fileTabBar->removeTab(0);
@@ -577,6 +822,8 @@ void MainWindow::openProjectFile(const QString& path) {
 
     delete m_project;
     m_project = newProject;
+    m_imageCache.clear();
+    m_resultCache.clear();
 
     applyProjectSettingsToUi();
 
@@ -584,7 +831,8 @@ void MainWindow::openProjectFile(const QString& path) {
     for (int i = 0; i < m_project->fileCount(); i++) {
         auto& entry = m_project->fileAt(i);
         if (!entry.sourcePath.isEmpty()) {
-            entry.sourcePixmap.load(entry.sourcePath);
+            // Decoded lazily, when the tab is activated or the file is processed
+            entry.sourceSize = QImageReader(entry.sourcePath).size();
             QFileInfo info(entry.sourcePath);
             m_fileTabBar->addTab(info.fileName());
         }
@@ -598,6 +846,7 @@ void MainWindow::openProjectFile(const QString& path) {
         }
         switchToFile(0);
     }
+    updateWatchedFiles();
 
     updateWindowTitle();
     updateRecentProjectsMenu();
@@ -693,33 +942,59 @@ void MainWindow::updateRecentProjectsMenu() {
 
 void MainWindow::importFiles(QStringList paths) {
     hideMessage();
+    readUiIntoProjectSettings();
     int firstNew = -1;
+    QStringList failed;
+    QStringList misaligned;
+
+    // The grid the source is expected to be made of
+    const auto& settings = m_project->settings();
+    int gridWidth = settings.tileWidth;
+    int gridHeight = settings.tileHeight;
+    if (settings.removePadding) {
+        gridWidth += settings.padding * 2;
+        gridHeight += settings.padding * 2;
+    }
 
     // Block tab bar signals during batch import to avoid switchToFile calls mid-loop
     m_fileTabBar->blockSignals(true);
 
     for (const QString& path : paths) {
-        int index = m_project->addFile(path);
-        auto& entry = m_project->fileAt(index);
-
-        if (!entry.sourcePixmap.load(path)) {
-            showError("Could not load: " + path);
-            m_project->removeFile(index);
+        // Only the header is read here, the file is decoded and processed on the worker pool
+        QImageReader reader(path);
+        QSize size = reader.size();
+        if (!reader.canRead() || !size.isValid()) {
+            failed.append(path);
             continue;
         }
 
+        int index = m_project->addFile(path);
+        auto& entry = m_project->fileAt(index);
+        entry.sourceSize = size;
+
         QFileInfo info(path);
-        m_fileTabBar->addTab(info.fileName());
+        int tab = m_fileTabBar->addTab(info.fileName());
+        if (size.width() % gridWidth != 0 || size.height() % gridHeight != 0) {
+            misaligned.append(info.fileName());
+            m_fileTabBar->setTabToolTip(tab, QString("%1x%2 is not a multiple of the %3x%4 grid")
+                .arg(size.width()).arg(size.height()).arg(gridWidth).arg(gridHeight));
+        }
 
         if (firstNew < 0) {
             firstNew = index;
         }
 
-        // Process the file
         processFile(index);
     }
 
     m_fileTabBar->blockSignals(false);
+    updateWatchedFiles();
+
+    if (!failed.isEmpty()) {
+        showError("Could not load: " + failed.join(", "));
+    } else if (!misaligned.isEmpty()) {
+        showError("Image size is not a multiple of the tile size: " + misaligned.join(", "));
+    }
 
     if (firstNew >= 0) {
         int lastIndex = m_project->fileCount() - 1;
@@ -734,10 +1009,8 @@ void MainWindow::importFiles(QStringList paths) {
 void MainWindow::switchToFile(int index) {
     if (index < 0 || index >= m_project->fileCount()) {
         // No files - show empty state
-        sourcePixmapDropWidget->setPixmap(new QPixmap());
-        sourcePixmapDropWidget->update();
-        resultPixmapDropWidget->setPixmap(new QPixmap());
-        resultPixmapDropWidget->update();
+        sourcePixmapDropWidget->setPixmap(QPixmap());
+        resultPixmapDropWidget->setPixmap(QPixmap());
         exportEdit->clear();
         reprocessButton->setEnabled(false);
         exportButton->setEnabled(false);
@@ -749,20 +1022,12 @@ void MainWindow::switchToFile(int index) {
     storeCurrentFileState();
 
     m_currentFileIndex = index;
+    ensureFileLoaded(index);
     auto& entry = m_project->fileAt(index);
 
-    // Update pixmap displays
-    auto srcPix = new QPixmap(entry.sourcePixmap);
-    sourcePixmapDropWidget->setPixmap(srcPix);
-    sourcePixmapDropWidget->update();
-
-    if (entry.processed) {
-        auto resPix = new QPixmap(entry.resultPixmap);
-        resultPixmapDropWidget->setPixmap(resPix);
-    } else {
-        resultPixmapDropWidget->setPixmap(new QPixmap());
-    }
-    resultPixmapDropWidget->update();
+    // Update pixmap displays, the widgets share the entry's pixmaps
+    sourcePixmapDropWidget->setPixmap(entry.sourcePixmap);
+    resultPixmapDropWidget->setPixmap(entry.processed ? entry.resultPixmap : QPixmap());
 
     updateReferenceSize(index);
 
@@ -771,14 +1036,6 @@ void MainWindow::switchToFile(int index) {
     reprocessButton->setEnabled(true);
     exportButton->setEnabled(entry.processed);
 
-    // Update file watcher
-    if (!fileWatcher->files().isEmpty()) {
-        fileWatcher->removePaths(fileWatcher->files());
-    }
-    if (watchFileCheckBox->isChecked() && !entry.sourcePath.isEmpty()) {
-        fileWatcher->addPath(entry.sourcePath);
-    }
-
     tabWidget->setCurrentIndex(0); // Show source tab
 }
 
@@ -797,8 +1054,9 @@ void MainWindow::updateReferenceSize(int fileIndex) {
         return;
     }
     auto& entry = m_project->fileAt(fileIndex);
-    int maxW = entry.sourcePixmap.width();
-    int maxH = entry.sourcePixmap.height();
+    QSize sourceSize = entry.sourcePixmap.isNull() ? entry.sourceSize : entry.sourcePixmap.size();
+    int maxW = sourceSize.width();
+    int maxH = sourceSize.height();
     if (entry.processed && !entry.resultPixmap.isNull()) {
         maxW = qMax(maxW, entry.resultPixmap.width());
         maxH = qMax(maxH, entry.resultPixmap.height());
@@ -813,16 +1071,11 @@ void MainWindow::closeFileTab(int index) {
         return;
     }
 
-    // Remove watcher if this is the current file
-    if (index == m_currentFileIndex) {
-        auto& entry = m_project->fileAt(index);
-        if (!entry.sourcePath.isEmpty() && fileWatcher->files().contains(entry.sourcePath)) {
-            fileWatcher->removePath(entry.sourcePath);
-        }
-    }
-
+    m_imageCache.remove(m_project->fileAt(index).id);
+    m_resultCache.removeFile(m_project->fileAt(index).id);
     m_project->removeFile(index);
     m_fileTabBar->removeTab(index);
+    updateWatchedFiles();
 
     if (m_currentFileIndex >= m_project->fileCount()) {
         m_currentFileIndex = m_project->fileCount() - 1;
@@ -838,124 +1091,350 @@ void MainWindow::closeFileTab(int index) {
     updateWindowTitle();
 }
 
-void MainWindow::processFile(int index) {
+void MainWindow::processFile(int index, bool autoExport, bool live) {
     if (index < 0 || index >= m_project->fileCount()) {
         return;
     }
 
     auto& entry = m_project->fileAt(index);
-    if (entry.sourcePixmap.isNull()) {
+    if (entry.sourcePixmap.isNull() && entry.sourcePath.isEmpty()) {
         return;
     }
 
-    // Create image from source pixmap
-    QByteArray bArray;
-    QBuffer buffer(&bArray);
-    buffer.open(QIODevice::WriteOnly);
-    entry.sourcePixmap.save(&buffer, "PNG");
-    buffer.close();
-    QImage sourceImage = QImage::fromData(bArray);
+    readUiIntoProjectSettings();
+    if (useCachedResult(index, autoExport)) {
+        return;
+    }
 
-    QImage* resultImage;
-    if (removePaddingCheckBox->isChecked()) {
-        setUpRemover();
-        resultImage = paddingRemover.create(&sourceImage);
-    } else {
-        setUpGenerator();
-        resultImage = paddingGenerator.create(&sourceImage);
+    // The padding runs on the worker pool, the result arrives in fileProcessed()
+    ProcessingJob job;
+    job.fileId = entry.id;
+    // Also with the source decoded: the disk cache key is the hash of the file's bytes
+    job.sourcePath = entry.sourcePath;
+    if (!entry.sourcePixmap.isNull()) {
+        job.source = entry.sourcePixmap.toImage();
+        job.sourceKey = entry.sourceKey;
     }
+    job.settings = m_project->settings();
+    entry.processedSettings = job.settings;
+    m_pendingFiles.insert(entry.id);
+    m_restoringFiles.remove(entry.id);
 
-    entry.resultPixmap = QPixmap::fromImage(*resultImage);
-    // Don't delete resultImage — it's owned by paddingGenerator/paddingRemover
+    // Live previews of large sheets stream in band by band, visible part first
+    if (live) {
+        QRect visible = resultPixmapDropWidget->visibleImageRect();
+        job.progressive = true;
+        job.priorityY = visible.isValid() ? visible.center().y() : 0;
+    }
+
+    // Auto-export if export path is set
+    if (autoExport && canExport(entry)) {
+        job.exportPath = entry.exportPath;
+        job.exportStamp = entry.exportStamp;
+    }
+    m_worker->submit(job);
+}
+
+bool MainWindow::useCachedResult(int index, bool autoExport) {
+    auto& entry = m_project->fileAt(index);
+    const ProjectSettings& settings = m_project->settings();
+    QPixmap cached = m_resultCache.find(entry.id, entry.sourceKey, settings);
+    if (cached.isNull()) {
+        return false;
+    }
+    m_restoringFiles.remove(entry.id);
+    entry.processedSettings = settings;
+
+    // Only the write is left, the worker skips decoding and padding
+    if (autoExport && canExport(entry)) {
+        ProcessingJob job;
+        job.fileId = entry.id;
+        job.sourceKey = entry.sourceKey;
+        job.padded = cached.toImage();
+        job.settings = settings;
+        job.exportPath = entry.exportPath;
+        job.exportStamp = entry.exportStamp;
+        m_pendingFiles.insert(entry.id);
+        m_worker->submit(job);
+        return true;
+    }
 
+    // A job still running for the file would overwrite this with older settings
+    m_worker->supersede(entry.id);
+    m_pendingFiles.remove(entry.id);
+    entry.resultPixmap = cached;
     entry.processed = true;
     entry.dirty = true;
-
-    // Auto-export if export path is set
-    if (!entry.exportPath.isEmpty()) {
-        exportFile(index);
+    if (index == m_currentFileIndex) {
+        showResult(index);
+        if (entry.id == m_pendingReprocessId) {
+            tabWidget->setCurrentIndex(1);
+            showInfo("Reprocessing complete.");
+        }
+    }
+    if (entry.id == m_pendingReprocessId) {
+        m_pendingReprocessId = 0;
     }
+    cacheFile(index);
+    return true;
 }
 
-void MainWindow::exportFile(int index) {
-    if (index < 0 || index >= m_project->fileCount()) {
-        return;
+void MainWindow::fileProcessed(const ProcessingResult& result) {
+    bool restored = false;
+    if (result.decodeOnly) {
+        m_decodingFiles.remove(result.fileId);
+    } else {
+        m_pendingFiles.remove(result.fileId);
+        restored = m_restoringFiles.remove(result.fileId);
+    }
+
+    int index = m_project->indexOfFile(result.fileId);
+    if (index < 0) {
+        return; // The file was closed in the meantime
     }
 
     auto& entry = m_project->fileAt(index);
-    if (!entry.processed || entry.resultPixmap.isNull()) {
+    if (!result.error.isEmpty()) {
+        showError(result.error);
+        return;
+    }
+    if (!result.source.isNull()) {
+        {
+            TraceScope scope("sourceFromImage", result.fileId);
+            entry.sourcePixmap = QPixmap::fromImage(result.source);
+        }
+        entry.sourceSize = result.source.size();
+        if (index == m_currentFileIndex) {
+            sourcePixmapDropWidget->setPixmap(entry.sourcePixmap);
+        }
+    }
+    if (result.decodeOnly) {
+        // The file may have changed since it was hashed
+        entry.sourceKey = result.sourceKey;
+        cacheFile(index);
         return;
     }
+    {
+        TraceScope scope("resultFromImage", result.fileId);
+        entry.resultPixmap = QPixmap::fromImage(result.image);
+    }
+    entry.processed = true;
+    if (result.sourceKey != 0) {
+        entry.sourceKey = result.sourceKey;
+        m_resultCache.insert(entry.id, result.sourceKey, result.settings, entry.resultPixmap);
+    }
+    if (!restored) {
+        entry.dirty = true;
+    }
+
+    if (result.exported) {
+        if (result.exportResult != ImageWriter::Result::Failed) {
+            entry.dirty = false;
+            entry.exportStamp = result.exportStamp;
+        }
+        if (m_exportAllRunning) {
+            switch (result.exportResult) {
+            case ImageWriter::Result::Written:
+                m_exportAllWritten++;
+                break;
+            case ImageWriter::Result::Skipped:
+                m_exportAllSkipped++;
+                break;
+            case ImageWriter::Result::Failed:
+                m_exportAllErrors++;
+                break;
+            }
+        }
+    }
+
+    if (index == m_currentFileIndex) {
+        showResult(index);
+        if (result.fileId == m_pendingReprocessId) {
+            tabWidget->setCurrentIndex(1);
+            showInfo("Reprocessing complete.");
+        }
+    }
+    if (result.fileId == m_pendingReprocessId) {
+        m_pendingReprocessId = 0;
+    }
+
+    cacheFile(index);
+}
 
-    QString exportPath = entry.exportPath;
-    if (exportPath.isEmpty()) {
+void MainWindow::processingFinished(bool cancelled) {
+    m_progressWidget->setVisible(false);
+    m_pendingReprocessId = 0;
+    m_pendingFiles.clear();
+    m_restoringFiles.clear();
+    m_decodingFiles.clear();
+
+    if (!m_exportAllRunning) {
+        if (cancelled) {
+            showInfo("Processing cancelled.");
+        }
         return;
     }
 
-    QFileInfo fileInfo(exportPath);
-    auto format = fileInfo.suffix().toUpper();
-    auto dir = fileInfo.dir();
-    if (!dir.exists()) {
+    m_exportAllRunning = false;
+    exportAllButton->setEnabled(m_project->fileCount() > 0);
+
+    QString summary = QString("Exported %1 files.").arg(m_exportAllWritten);
+    if (cancelled) {
+        summary = "Export All cancelled. " + summary;
+    }
+    if (m_exportAllSkipped > 0) {
+        summary += QString(" %1 files were unchanged and not rewritten.").arg(m_exportAllSkipped);
+    }
+    if (m_exportAllErrors > 0) {
+        summary += QString(" %1 files had errors.").arg(m_exportAllErrors);
+    }
+    showInfo(summary);
+}
+
+void MainWindow::settingsChanged() {
+    if (livePreviewCheckBox->isChecked() && m_currentFileIndex >= 0) {
+        m_livePreviewTimer->start();
+    }
+}
+
+void MainWindow::livePreview() {
+    if (!livePreviewCheckBox->isChecked() || m_exportAllRunning) {
         return;
     }
-    if (format == "JPEG") {
-        format = "JPG";
+    if (m_currentFileIndex < 0 || m_currentFileIndex >= m_project->fileCount()) {
+        return;
+    }
+    // A newer job for the same file supersedes the one still running
+    processFile(m_currentFileIndex, false, true);
+    tabWidget->setCurrentIndex(1);
+}
+
+void MainWindow::bandProcessed(quint64 fileId, QSize targetSize, QPoint offset, const QImage& band) {
+    if (m_currentFileIndex < 0 || m_currentFileIndex >= m_project->fileCount()) {
+        return;
     }
-    if (format != "PNG" && format != "JPG") {
+    if (m_project->fileAt(m_currentFileIndex).id != fileId) {
         return;
     }
 
-    entry.resultPixmap.save(exportPath, format.toStdString().c_str());
-    entry.dirty = false;
+    // Finished bands are painted over the previous result until the whole sheet arrives
+    if (resultPixmapDropWidget->pixmap().size() != targetSize) {
+        QPixmap blank(targetSize);
+        blank.fill(Qt::transparent);
+        resultPixmapDropWidget->setPixmap(blank);
+    }
+    resultPixmapDropWidget->drawImage(offset, band);
 }
 
-void MainWindow::reprocess() {
-    if (m_currentFileIndex < 0) {
+void MainWindow::showResult(int index) {
+    auto& entry = m_project->fileAt(index);
+    resultPixmapDropWidget->setPixmap(entry.processed ? entry.resultPixmap : QPixmap());
+    updateReferenceSize(index);
+    exportButton->setEnabled(entry.processed);
+}
+
+void MainWindow::ensureFileLoaded(int index) {
+    auto& entry = m_project->fileAt(index);
+    if (entry.processed && entry.resultPixmap.isNull()) {
+        entry.resultPixmap = m_resultCache.find(entry.id, entry.sourceKey, entry.processedSettings);
+    }
+    if (entry.processed && entry.resultPixmap.isNull()) {
+        // Evicted: recompute it (which also decodes the source) with the settings it was made with
+        if (!m_pendingFiles.contains(entry.id)) {
+            ProcessingJob job;
+            job.fileId = entry.id;
+            if (entry.sourcePixmap.isNull()) {
+                job.sourcePath = entry.sourcePath;
+            } else {
+                job.source = entry.sourcePixmap.toImage();
+            }
+            job.settings = entry.processedSettings;
+            m_pendingFiles.insert(entry.id);
+            m_restoringFiles.insert(entry.id);
+            m_worker->submit(job);
+        }
         return;
     }
-    hideMessage();
-    readUiIntoProjectSettings();
-    storeCurrentFileState();
-
-    processFile(m_currentFileIndex);
+    if (entry.sourcePixmap.isNull() && !entry.sourcePath.isEmpty() && !m_pendingFiles.contains(entry.id)
+        && !m_decodingFiles.contains(entry.id)) {
+        // Evicted: decoded on the worker, the source arrives in fileProcessed()
+        ProcessingJob job;
+        job.fileId = entry.id;
+        job.sourcePath = entry.sourcePath;
+        job.settings = entry.processedSettings;
+        job.decodeOnly = true;
+        m_decodingFiles.insert(entry.id);
+        m_worker->submit(job);
+    }
+    cacheFile(index);
+}
 
-    // Update result display
-    auto& entry = m_project->fileAt(m_currentFileIndex);
-    auto resPix = new QPixmap(entry.resultPixmap);
-    resultPixmapDropWidget->setPixmap(resPix);
-    resultPixmapDropWidget->update();
-    updateReferenceSize(m_currentFileIndex);
-    tabWidget->setCurrentIndex(1);
-    exportButton->setEnabled(true);
+void MainWindow::cacheFile(int index) {
+    auto& entry = m_project->fileAt(index);
+    m_imageCache.touch(entry.id, ImageCache::pixmapBytes(entry.sourcePixmap) + ImageCache::pixmapBytes(entry.resultPixmap));
+    enforceImageBudget();
+}
 
-    showInfo("Reprocessing complete.");
+void MainWindow::enforceImageBudget() {
+    quint64 keepId = 0;
+    if (m_currentFileIndex >= 0 && m_currentFileIndex < m_project->fileCount()) {
+        keepId = m_project->fileAt(m_currentFileIndex).id;
+    }
+    for (quint64 id : m_imageCache.evictionCandidates(keepId)) {
+        m_imageCache.remove(id);
+        int index = m_project->indexOfFile(id);
+        if (index < 0) {
+            continue;
+        }
+        // The source is decoded again and the result recomputed when the file is needed
+        auto& entry = m_project->fileAt(index);
+        entry.sourcePixmap = QPixmap();
+        entry.resultPixmap = QPixmap();
+    }
 }
 
-void MainWindow::setUpGenerator() {
-    paddingGenerator.setTileSize(tileWidthSpinBox->value(), tileHeightSpinBox->value());
-    paddingGenerator.setPadding(paddingSpinBox->value());
-    paddingGenerator.setForcePot(forcePotCheckBox->isChecked());
-    paddingGenerator.setReorder(reorderCheckBox->isChecked());
-    paddingGenerator.setTransparent(transparentCheckBox->isChecked());
-    paddingGenerator.setBackgroundColor(backgroundColorEdit->getColor());
+bool MainWindow::canExport(const FileEntry& entry) const {
+    if (entry.exportPath.isEmpty()) {
+        return false;
+    }
+    if (!QFileInfo(entry.exportPath).dir().exists()) {
+        return false;
+    }
+    return !ImageWriter::formatForPath(entry.exportPath).isEmpty();
 }
 
-void MainWindow::setUpRemover() {
-    paddingRemover.setTileSize(tileWidthSpinBox->value(), tileHeightSpinBox->value());
-    paddingRemover.setPadding(paddingSpinBox->value());
+ImageWriter::Result MainWindow::exportFile(int index) {
+    if (index < 0 || index >= m_project->fileCount()) {
+        return ImageWriter::Result::Failed;
+    }
+
+    auto& entry = m_project->fileAt(index);
+    if (!entry.processed || entry.resultPixmap.isNull()) {
+        return ImageWriter::Result::Failed;
+    }
+
+    if (!canExport(entry)) {
+        return ImageWriter::Result::Failed;
+    }
+
+    auto result = ImageWriter::write(entry.resultPixmap.toImage(), entry.exportPath,
+        ImageWriter::formatForPath(entry.exportPath), &entry.exportStamp);
+    if (result != ImageWriter::Result::Failed) {
+        entry.dirty = false;
+    }
+    return result;
 }
 
-QImage* MainWindow::createImageFromSource(int fileIndex) {
-    if (fileIndex < 0 || fileIndex >= m_project->fileCount()) {
-        return new QImage();
+void MainWindow::reprocess() {
+    if (m_currentFileIndex < 0) {
+        return;
     }
-    auto& entry = m_project->fileAt(fileIndex);
-    QByteArray bArray;
-    QBuffer buffer(&bArray);
-    buffer.open(QIODevice::WriteOnly);
-    entry.sourcePixmap.save(&buffer, "PNG");
-    buffer.close();
-    return new QImage(QImage::fromData(bArray));
+    hideMessage();
+    readUiIntoProjectSettings();
+    storeCurrentFileState();
+
+    m_pendingReprocessId = m_project->fileAt(m_currentFileIndex).id;
+    processFile(m_currentFileIndex);
 }
 
 void MainWindow::browseButtonClicked() {
@@ -998,111 +1477,153 @@ void MainWindow::exportButtonClicked() {
     storeCurrentFileState();
 
     auto& entry = m_project->fileAt(m_currentFileIndex);
-    auto exportPath = entry.exportPath;
-    QFileInfo fileInfo(exportPath);
-    auto format = fileInfo.suffix().toUpper();
-    auto dir = fileInfo.dir();
+    QFileInfo fileInfo(entry.exportPath);
 
-    if (!dir.exists()) {
+    if (!fileInfo.dir().exists()) {
         showError("The export directory doesn't exist.");
         return;
     }
-    if (format == "JPEG") {
-        format = "JPG";
-    }
-    if (format != "PNG" && format != "JPG") {
+    if (ImageWriter::formatForPath(entry.exportPath).isEmpty()) {
         showError("The export extension must be .png, .jpg or .jpeg.");
         return;
     }
+    if (entry.processed && entry.resultPixmap.isNull()) {
+        showInfo("The result is still being loaded, try again in a moment.");
+        return;
+    }
 
-    exportFile(m_currentFileIndex);
-    showInfo("Export complete.");
+    switch (exportFile(m_currentFileIndex)) {
+    case ImageWriter::Result::Written:
+        showInfo("Export complete.");
+        break;
+    case ImageWriter::Result::Skipped:
+        showInfo("Export is up to date, the file was not rewritten.");
+        break;
+    case ImageWriter::Result::Failed:
+        showError("Could not export: " + entry.exportPath);
+        break;
+    }
 }
 
 void MainWindow::exportAllButtonClicked() {
+    if (m_exportAllRunning) {
+        return;
+    }
     hideMessage();
     readUiIntoProjectSettings();
     storeCurrentFileState();
 
-    int exported = 0;
-    int errors = 0;
+    m_exportAllRunning = true;
+    m_exportAllWritten = 0;
+    m_exportAllSkipped = 0;
+    m_exportAllErrors = 0;
+    exportAllButton->setEnabled(false);
 
     for (int i = 0; i < m_project->fileCount(); i++) {
         auto& entry = m_project->fileAt(i);
         if (!entry.dirty || !entry.processed) {
             continue;
         }
-
-        // Reprocess with current settings
-        processFile(i);
-
-        if (entry.exportPath.isEmpty()) {
-            errors++;
-            continue;
+        if (!canExport(entry)) {
+            m_exportAllErrors++;
         }
 
-        QFileInfo fileInfo(entry.exportPath);
-        if (!fileInfo.dir().exists()) {
-            errors++;
-            continue;
-        }
-
-        exported++;
+        // Reprocess with current settings, the worker exports the result
+        processFile(i);
     }
 
-    // Update current file display
-    if (m_currentFileIndex >= 0) {
-        auto& entry = m_project->fileAt(m_currentFileIndex);
-        auto resPix = new QPixmap(entry.resultPixmap);
-        resultPixmapDropWidget->setPixmap(resPix);
-        resultPixmapDropWidget->update();
+    if (!m_worker->isBusy()) {
+        processingFinished(false);
     }
+}
 
-    if (errors > 0) {
-        showInfo(QString("Exported %1 files. %2 files had errors.").arg(exported).arg(errors));
+void MainWindow::watchFileCheckBoxStateChanged(Qt::CheckState state) {
+    Q_UNUSED(state);
+    updateWatchedFiles();
+}
+
+void MainWindow::updateWatchedFiles() {
+    m_watchedFiles.clear();
+    if (watchFileCheckBox->isChecked()) {
+        for (int i = 0; i < m_project->fileCount(); i++) {
+            const auto& entry = m_project->fileAt(i);
+            if (!entry.sourcePath.isEmpty()) {
+                m_watchedFiles.insert(entry.sourcePath, entry.id);
+            }
+        }
     } else {
-        showInfo(QString("Exported %1 files.").arg(exported));
+        m_changedFiles.clear();
     }
-}
 
-void MainWindow::watchFileCheckBoxStateChanged(Qt::CheckState state) {
-    if (m_currentFileIndex < 0 || m_currentFileIndex >= m_project->fileCount()) {
-        return;
+    QStringList files = fileWatcher->files();
+    QSet<QString> watched(files.begin(), files.end());
+    QStringList removed;
+    for (const QString& path : watched) {
+        if (!m_watchedFiles.contains(path)) {
+            removed.append(path);
+        }
     }
-    auto& entry = m_project->fileAt(m_currentFileIndex);
-    if (entry.sourcePath.isEmpty()) {
-        return;
+    QStringList added;
+    for (const QString& path : m_watchedFiles.uniqueKeys()) {
+        if (!watched.contains(path)) {
+            added.append(path);
+        }
     }
-    if (state == Qt::Checked) {
-        fileWatcher->addPath(entry.sourcePath);
-    } else {
-        fileWatcher->removePath(entry.sourcePath);
+    if (!removed.isEmpty()) {
+        fileWatcher->removePaths(removed);
+    }
+    if (!added.isEmpty()) {
+        fileWatcher->addPaths(added);
     }
 }
 
 void MainWindow::sourceFileChanged(const QString& path) {
-    if (m_currentFileIndex < 0 || m_currentFileIndex >= m_project->fileCount()) {
-        return;
-    }
-    auto& entry = m_project->fileAt(m_currentFileIndex);
-    if (path != entry.sourcePath || !watchFileCheckBox->isChecked()) {
-        return;
-    }
-    if (!entry.sourcePixmap.load(entry.sourcePath)) {
+    if (!m_watchedFiles.contains(path)) {
         return;
     }
-    fileWatcher->addPath(entry.sourcePath);
-
-    // Update source display
-    auto srcPix = new QPixmap(entry.sourcePixmap);
-    sourcePixmapDropWidget->setPixmap(srcPix);
-    sourcePixmapDropWidget->update();
+    // Editors write in several steps, wait until the events stop coming
+    m_changedFiles.insert(path, 0);
+    m_watchTimer->start();
+}
 
-    // Reprocess (which auto-exports)
-    processFile(m_currentFileIndex);
+void MainWindow::reloadChangedFiles() {
+    QHash<QString, int> retry;
+    int reprocessed = 0;
+    for (auto it = m_changedFiles.cbegin(); it != m_changedFiles.cend(); ++it) {
+        const QString& path = it.key();
+        if (!QFileInfo::exists(path)) {
+            // Saved by writing a temporary file and renaming it over the source
+            if (it.value() < WatchRetries) {
+                retry.insert(path, it.value() + 1);
+            }
+            continue;
+        }
+        // The watch is lost when the file is replaced
+        if (!fileWatcher->files().contains(path)) {
+            fileWatcher->addPath(path);
+        }
 
-    auto resPix = new QPixmap(entry.resultPixmap);
-    resultPixmapDropWidget->setPixmap(resPix);
-    resultPixmapDropWidget->update();
-    updateReferenceSize(m_currentFileIndex);
+        QSize size = QImageReader(path).size();
+        for (quint64 id : m_watchedFiles.values(path)) {
+            int index = m_project->indexOfFile(id);
+            if (index < 0) {
+                continue;
+            }
+            // Decoded again by the worker, which also reprocesses and exports it
+            auto& entry = m_project->fileAt(index);
+            entry.sourcePixmap = QPixmap();
+            entry.sourceKey = 0;
+            entry.sourceSize = size;
+            m_resultCache.removeFile(id);
+            processFile(index);
+            reprocessed++;
+        }
+    }
+    m_changedFiles = retry;
+    if (!m_changedFiles.isEmpty()) {
+        m_watchTimer->start();
+    }
+    if (reprocessed > 1) {
+        showInfo(QString("%1 changed files are being reprocessed.").arg(reprocessed));
+    }
 }
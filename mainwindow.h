@@ -8,17 +8,28 @@
 #include <QTabWidget>
 #include <QTabBar>
 #include <QPushButton>
+#include <QProgressBar>
 #include <QFileSystemWatcher>
 #include <QActionGroup>
 #include <QMenu>
+#include <QSet>
+#include <QMultiHash>
+#include <QTimer>
+#include <QToolButton>
+
+#include <memory>
 
 #include "pixmapdropwidget.h"
-#include "paddinggenerator.h"
-#include "paddingremover.h"
 #include "coloredit.h"
 #include "thememanager.h"
 #include "titlebar.h"
 #include "project.h"
+#include "imagewriter.h"
+#include "processingworker.h"
+#include "imagecache.h"
+#include "resultcache.h"
+#include "diskcache.h"
+#include "memorydialog.h"
 
 class MainWindow : public QMainWindow
 {
@@ -42,6 +53,12 @@ public slots:
     void exportAllButtonClicked();
     void watchFileCheckBoxStateChanged(Qt::CheckState state);
     void sourceFileChanged(const QString& path);
+    void reloadChangedFiles();
+    void fileProcessed(const ProcessingResult& result);
+    void processingFinished(bool cancelled);
+    void bandProcessed(quint64 fileId, QSize targetSize, QPoint offset, const QImage& band);
+    void settingsChanged();
+    void livePreview();
 
 protected:
     bool nativeEvent(const QByteArray& eventType, void* message, qintptr* result) override;
@@ -55,9 +72,6 @@ private:
     void setupFileMenu();
     void setupThemeMenu();
     void createLayout();
-    void setUpGenerator();
-    void setUpRemover();
-    QImage* createImageFromSource(int fileIndex);
     void loadAppSettings();
     void saveAppSettings();
     void applyProjectSettingsToUi();
@@ -77,10 +91,23 @@ private:
     // File tab operations
     void switchToFile(int index);
     void closeFileTab(int index);
-    void processFile(int index);
-    void exportFile(int index);
+    void processFile(int index, bool autoExport = true, bool live = false);
+    bool useCachedResult(int index, bool autoExport);
+    ImageWriter::Result exportFile(int index);
+    bool canExport(const FileEntry& entry) const;
+    void showResult(int index);
+    void ensureFileLoaded(int index);
+    void cacheFile(int index);
+    void enforceImageBudget();
+    void editImageBudget();
+    void toggleTrace(bool enabled);
+    MemoryUsage memoryUsage() const;
+    void updateMemoryStatus();
+    void showMemoryUsage();
+    void purgeInactiveFiles();
     void storeCurrentFileState();
     void updateReferenceSize(int fileIndex);
+    void updateWatchedFiles();
 
     int m_currentFileIndex = -1;
 
@@ -95,6 +122,7 @@ private:
     QCheckBox* forcePotCheckBox;
     QCheckBox* reorderCheckBox;
     QCheckBox* removePaddingCheckBox;
+    QCheckBox* livePreviewCheckBox;
     QCheckBox* transparentCheckBox;
     ColorEdit* backgroundColorEdit;
     QTabBar* m_fileTabBar;
@@ -109,16 +137,37 @@ private:
     QPushButton* browseButton;
     QPushButton* exportButton;
     QPushButton* exportAllButton;
+    QWidget* m_progressWidget;
+    QProgressBar* m_progressBar;
+    QPushButton* m_cancelButton;
 
     QAction* m_systemThemeAction;
     QAction* m_darkThemeAction;
     QAction* m_lightThemeAction;
     QMenu* m_recentMenu;
+    QAction* m_traceAction;
+    QToolButton* m_memoryButton;
+    QTimer* m_memoryTimer;
+    MemoryDialog* m_memoryDialog = nullptr;
 
     QFileSystemWatcher* fileWatcher;
-
-    PaddingGenerator paddingGenerator;
-    PaddingRemover paddingRemover;
+    QMultiHash<QString, quint64> m_watchedFiles; // Source path -> ids of the files using it
+    QHash<QString, int> m_changedFiles;          // Changed source path -> reload attempts so far
+    QTimer* m_watchTimer;
+    QTimer* m_livePreviewTimer;
+
+    ProcessingWorker* m_worker;
+    ImageCache m_imageCache;
+    ResultCache m_resultCache;
+    std::unique_ptr<DiskCache> m_diskCache; // Null when disabled
+    QSet<quint64> m_pendingFiles;
+    QSet<quint64> m_restoringFiles;
+    QSet<quint64> m_decodingFiles; // Evicted sources decoded again on the worker
+    quint64 m_pendingReprocessId = 0;
+    bool m_exportAllRunning = false;
+    int m_exportAllWritten = 0;
+    int m_exportAllSkipped = 0;
+    int m_exportAllErrors = 0;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,117 @@
+#include "memorydialog.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+
+qint64 MemoryUsage::imageBytes() const {
+    qint64 total = 0;
+    for (const File& file : files) {
+        total += file.sourceBytes + file.resultBytes;
+    }
+    return total;
+}
+
+qint64 MemoryUsage::totalBytes() const {
+    return imageBytes() + previewBytes + rememberedBytes + processingBytes;
+}
+
+MemoryDialog::MemoryDialog(QWidget* parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Memory Usage");
+    setMinimumSize(520, 400);
+    createLayout();
+}
+
+QString MemoryDialog::formatBytes(qint64 bytes) {
+    if (bytes >= 1024LL * 1024 * 1024) {
+        return QString("%1 GB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 2);
+    }
+    if (bytes >= 1024 * 1024) {
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+    }
+    return QString("%1 KB").arg((bytes + 1023) / 1024);
+}
+
+void MemoryDialog::createLayout() {
+    auto mainLayout = new QVBoxLayout(this);
+    mainLayout->setSpacing(10);
+    mainLayout->setContentsMargins(16, 16, 16, 16);
+
+    // Decoded images per file
+    m_table = new QTableWidget(0, 4);
+    m_table->setHorizontalHeaderLabels({ "File", "Source", "Result", "State" });
+    m_table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    mainLayout->addWidget(m_table, 1);
+
+    m_summaryLabel = new QLabel();
+    mainLayout->addWidget(m_summaryLabel);
+    m_diskCacheLabel = new QLabel();
+    mainLayout->addWidget(m_diskCacheLabel);
+
+    // Purge actions
+    auto buttonLayout = new QHBoxLayout();
+    buttonLayout->setSpacing(8);
+
+    auto purgeButton = new QPushButton("Purge Inactive Files");
+    purgeButton->setToolTip("Drops the decoded images and remembered results of every file except "
+                            "the current one. They are decoded and padded again when the file is opened.");
+    connect(purgeButton, &QPushButton::clicked, this, &MemoryDialog::purgeInactiveFilesRequested);
+
+    auto resultsButton = new QPushButton("Clear Remembered Results");
+    resultsButton->setObjectName("secondaryButton");
+    connect(resultsButton, &QPushButton::clicked, this, &MemoryDialog::clearRememberedResultsRequested);
+
+    auto previewsButton = new QPushButton("Clear Previews");
+    previewsButton->setObjectName("secondaryButton");
+    connect(previewsButton, &QPushButton::clicked, this, &MemoryDialog::clearPreviewsRequested);
+
+    m_clearDiskCacheButton = new QPushButton("Clear Disk Cache");
+    m_clearDiskCacheButton->setObjectName("secondaryButton");
+    connect(m_clearDiskCacheButton, &QPushButton::clicked, this, &MemoryDialog::clearDiskCacheRequested);
+
+    buttonLayout->addWidget(purgeButton);
+    buttonLayout->addWidget(resultsButton);
+    buttonLayout->addWidget(previewsButton);
+    buttonLayout->addStretch(1);
+    buttonLayout->addWidget(m_clearDiskCacheButton);
+    mainLayout->addLayout(buttonLayout);
+}
+
+void MemoryDialog::setUsage(const MemoryUsage& usage) {
+    m_table->setRowCount(usage.files.size());
+    for (int i = 0; i < usage.files.size(); i++) {
+        const auto& file = usage.files[i];
+        QString state = file.processing ? "Processing" : file.current ? "Current" : "Inactive";
+        if (!file.processing && file.sourceBytes == 0 && file.resultBytes == 0) {
+            state = "Not loaded";
+        }
+        const QString columns[] = { file.name, formatBytes(file.sourceBytes), formatBytes(file.resultBytes), state };
+        for (int column = 0; column < 4; column++) {
+            auto item = new QTableWidgetItem(columns[column]);
+            if (column == 1 || column == 2) {
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            m_table->setItem(i, column, item);
+        }
+    }
+
+    m_summaryLabel->setText(QString(
+        "Decoded images: %1\n"
+        "Previews: %2\n"
+        "Remembered results: %3\n"
+        "Processing: %4\n"
+        "Total: %5")
+        .arg(formatBytes(usage.imageBytes()), formatBytes(usage.previewBytes), formatBytes(usage.rememberedBytes),
+             formatBytes(usage.processingBytes), formatBytes(usage.totalBytes())));
+}
+
+void MemoryDialog::setDiskCacheBytes(qint64 bytes) {
+    m_clearDiskCacheButton->setEnabled(bytes >= 0);
+    m_diskCacheLabel->setText(bytes >= 0 ? QString("Disk cache (not in memory): %1").arg(formatBytes(bytes))
+                                         : QString("Disk cache: off"));
+}
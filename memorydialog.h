@@ -0,0 +1,58 @@
+#ifndef MEMORYDIALOG_H
+#define MEMORYDIALOG_H
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QList>
+
+// What the open project holds in memory, collected by MainWindow
+struct MemoryUsage {
+    struct File {
+        QString name;
+        qint64 sourceBytes = 0;
+        qint64 resultBytes = 0;
+        bool current = false;
+        bool processing = false;
+    };
+
+    QList<File> files;
+    qint64 previewBytes = 0;    // Zoom levels and tiles of the Source and Result views
+    qint64 rememberedBytes = 0; // Results for other settings, kept by the ResultCache
+    qint64 processingBytes = 0; // Sources, targets and export buffers of the jobs in flight
+
+    qint64 imageBytes() const;
+    qint64 totalBytes() const;
+};
+
+// Memory use of the project per file, with actions to free it. Not modal,
+// MainWindow keeps it up to date while it is open.
+class MemoryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryDialog(QWidget* parent = nullptr);
+
+    void setUsage(const MemoryUsage& usage);
+    void setDiskCacheBytes(qint64 bytes); // -1: no disk cache
+
+    static QString formatBytes(qint64 bytes);
+
+signals:
+    void purgeInactiveFilesRequested();
+    void clearRememberedResultsRequested();
+    void clearPreviewsRequested();
+    void clearDiskCacheRequested();
+
+private:
+    void createLayout();
+
+    QTableWidget* m_table;
+    QLabel* m_summaryLabel;
+    QLabel* m_diskCacheLabel;
+    QPushButton* m_clearDiskCacheButton;
+};
+
+#endif // MEMORYDIALOG_H
@@ -0,0 +1,162 @@
+#include "paddingengine.h"
+#include "paddinggenerator.h"
+#include "paddingremover.h"
+
+#include <QColor>
+
+static QImage::Format imageFormat(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::Argb32Premultiplied:
+        return QImage::Format_ARGB32_Premultiplied;
+    case PixelFormat::Rgba8888:
+        return QImage::Format_RGBA8888;
+    case PixelFormat::Rgba8888Premultiplied:
+        return QImage::Format_RGBA8888_Premultiplied;
+    default:
+        return QImage::Format_ARGB32;
+    }
+}
+
+static bool isValidView(const PixelView& view) {
+    if (view.width < 0 || view.height < 0 || view.stride < ptrdiff_t(view.width) * 4) {
+        return false;
+    }
+    return view.data != nullptr || view.width == 0 || view.height == 0;
+}
+
+// Views of the caller's memory, QImage only wraps the buffer
+static QImage sourceImage(const PixelView& view) {
+    return QImage(static_cast<const uchar*>(view.data), view.width, view.height, view.stride, imageFormat(view.format));
+}
+
+static QImage targetImage(const PixelView& view) {
+    return QImage(static_cast<uchar*>(view.data), view.width, view.height, view.stride, imageFormat(view.format));
+}
+
+static void configure(PaddingGenerator& generator, const PaddingOptions& options) {
+    generator.setTileSize(options.tileWidth, options.tileHeight);
+    generator.setPadding(options.padding);
+    generator.setForcePot(options.forcePot);
+    generator.setReorder(options.reorder);
+    generator.setTransparent(options.transparent);
+    generator.setBackgroundColor(QColor::fromRgba(options.backgroundColor));
+}
+
+// Points the generator at the target, which must have the size of the layout
+static bool attach(PaddingGenerator& generator, int sourceWidth, int sourceHeight, const PixelView& target,
+                   const PaddingOptions& options) {
+    if (!PaddingEngine::fits(sourceWidth, sourceHeight, options) || !isValidView(target)) {
+        return false;
+    }
+    configure(generator, options);
+    if (generator.layout(QSize(sourceWidth, sourceHeight)) != QSize(target.width, target.height)) {
+        return false;
+    }
+    generator.setTarget(target.data, target.stride, imageFormat(target.format));
+    return true;
+}
+
+bool PaddingEngine::isValid(const PaddingOptions& options) {
+    return options.tileWidth > 0 && options.tileWidth <= MaxTileSize
+        && options.tileHeight > 0 && options.tileHeight <= MaxTileSize
+        && options.padding >= 0 && options.padding <= MaxTileSize;
+}
+
+bool PaddingEngine::fits(int sourceWidth, int sourceHeight, const PaddingOptions& options) {
+    if (!isValid(options) || sourceWidth < 0 || sourceHeight < 0) {
+        return false;
+    }
+    // Grid cells can be far larger than the tiles, in 64 bits it can't overflow
+    qint64 width = qint64(sourceWidth / options.tileWidth) * (options.tileWidth + options.padding * 2);
+    qint64 height = qint64(sourceHeight / options.tileHeight) * (options.tileHeight + options.padding * 2);
+    return width <= MaxTargetSize && height <= MaxTargetSize;
+}
+
+PaddingLayout PaddingEngine::layout(int sourceWidth, int sourceHeight, const PaddingOptions& options) {
+    PaddingLayout result;
+    if (!fits(sourceWidth, sourceHeight, options)) {
+        return result;
+    }
+    PaddingGenerator generator;
+    configure(generator, options);
+    QSize size = generator.layout(QSize(sourceWidth, sourceHeight));
+    result.cols = sourceWidth / options.tileWidth;
+    result.rows = sourceHeight / options.tileHeight;
+    result.gridWidth = options.tileWidth + options.padding * 2;
+    result.gridHeight = options.tileHeight + options.padding * 2;
+    result.width = size.width();
+    result.height = size.height();
+    result.tilesPerRow = generator.tilesPerRow();
+    result.bandRows = generator.bandRowCount();
+    return result;
+}
+
+bool PaddingEngine::pad(const PixelView& source, const PixelView& target, const PaddingOptions& options) {
+    if (!isValidView(source)) {
+        return false;
+    }
+    PaddingGenerator generator;
+    if (!attach(generator, source.width, source.height, target, options)) {
+        return false;
+    }
+    generator.clearTarget();
+    generator.renderBand(sourceImage(source), 0, generator.bandRowCount());
+    return true;
+}
+
+bool PaddingEngine::clear(const PixelView& target, const PaddingOptions& options) {
+    if (!isValid(options) || !isValidView(target)) {
+        return false;
+    }
+    QImage image = targetImage(target);
+    if (options.transparent) {
+        image.fill(Qt::transparent);
+    } else {
+        image.fill(QColor::fromRgba(options.backgroundColor));
+    }
+    return true;
+}
+
+bool PaddingEngine::renderBand(const PixelView& source, const PixelView& target, const PaddingOptions& options,
+                               int firstRow, int lastRow) {
+    if (!isValidView(source)) {
+        return false;
+    }
+    PaddingGenerator generator;
+    if (!attach(generator, source.width, source.height, target, options)) {
+        return false;
+    }
+    if (firstRow < 0 || firstRow > lastRow || lastRow > generator.bandRowCount()) {
+        return false;
+    }
+    generator.renderBand(sourceImage(source), firstRow, lastRow);
+    return true;
+}
+
+void PaddingEngine::removedSize(int sourceWidth, int sourceHeight, const PaddingOptions& options,
+                                int* width, int* height) {
+    QSize size;
+    if (isValid(options) && sourceWidth >= 0 && sourceHeight >= 0) {
+        PaddingRemover remover;
+        remover.setTileSize(options.tileWidth, options.tileHeight);
+        remover.setPadding(options.padding);
+        size = remover.targetSize(QSize(sourceWidth, sourceHeight));
+    }
+    *width = qMax(0, size.width());
+    *height = qMax(0, size.height());
+}
+
+bool PaddingEngine::removePadding(const PixelView& source, const PixelView& target, const PaddingOptions& options) {
+    if (!isValid(options) || !isValidView(source) || !isValidView(target)) {
+        return false;
+    }
+    PaddingRemover remover;
+    remover.setTileSize(options.tileWidth, options.tileHeight);
+    remover.setPadding(options.padding);
+    if (remover.targetSize(QSize(source.width, source.height)) != QSize(target.width, target.height)) {
+        return false;
+    }
+    QImage image = targetImage(target);
+    remover.render(sourceImage(source), image);
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef PADDINGENGINE_H
+#define PADDINGENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The public API of the tilepad_core library, for tools that pad their own
+// pixel buffers in-process. Source and target are views of memory owned by the
+// caller, nothing is copied or converted: the tiles are drawn from the source
+// rows straight into the target rows. The results equal the ones of the
+// application, which uses the same code through PaddingGenerator and
+// PaddingRemover. No Qt types and no QGuiApplication are needed.
+
+// 32-bit pixel layouts. Argb32 is 0xAARRGGBB in a native 32-bit word (B, G, R,
+// A in memory on little endian), Rgba8888 is R, G, B, A in memory.
+enum class PixelFormat {
+    Argb32,
+    Argb32Premultiplied,
+    Rgba8888,
+    Rgba8888Premultiplied
+};
+
+struct PixelView {
+    uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    ptrdiff_t stride = 0; // Bytes from one row to the next, at least width * 4
+    PixelFormat format = PixelFormat::Argb32;
+};
+
+struct PaddingOptions {
+    int tileWidth = 16;
+    int tileHeight = 16;
+    int padding = 1;
+    bool forcePot = true;
+    bool reorder = false; // Only with forcePot
+    bool transparent = true;
+    uint32_t backgroundColor = 0xFFFF00FF; // 0xAARRGGBB, when not transparent
+};
+
+// Where the tiles of a source go in the padded target. Tile i of the source
+// (row by row) is drawn in grid cell (i % tilesPerRow, i / tilesPerRow), at
+// padding pixels from the cell's top left corner.
+struct PaddingLayout {
+    int cols = 0; // Whole tiles in a source row
+    int rows = 0; // Whole tiles in a source column
+    int gridWidth = 0; // A tile with its padding on both sides
+    int gridHeight = 0;
+    int width = 0; // Of the target
+    int height = 0;
+    int tilesPerRow = 0;
+    int bandRows = 0; // Grid rows of the target, the range of renderBand()
+};
+
+class PaddingEngine
+{
+public:
+    // Limits that keep every size computation within int
+    static constexpr int MaxTileSize = 1 << 16; // Also of the padding
+    static constexpr int MaxTargetSize = 1 << 28; // A side of the target, before the power of two rounding
+
+    // False for tile sizes below 1 or a negative padding, or ones above MaxTileSize
+    static bool isValid(const PaddingOptions& options);
+
+    // False if a side of the padded target of the source would exceed MaxTargetSize
+    static bool fits(int sourceWidth, int sourceHeight, const PaddingOptions& options);
+
+    // All zero if the options are invalid or the source doesn't fit
+    static PaddingLayout layout(int sourceWidth, int sourceHeight, const PaddingOptions& options);
+
+    // Pads the source into a target of layout().width x layout().height
+    static bool pad(const PixelView& source, const PixelView& target, const PaddingOptions& options);
+
+    // pad() in steps that can run on several threads: clear() fills the
+    // target with the background once, then every band of target grid rows
+    // [firstRow, lastRow) can be rendered independently and concurrently.
+    // The last band also covers the rows below the grid.
+    static bool clear(const PixelView& target, const PaddingOptions& options);
+    static bool renderBand(const PixelView& source, const PixelView& target, const PaddingOptions& options,
+                           int firstRow, int lastRow);
+
+    // Size of the target of removePadding() for a padded source
+    static void removedSize(int sourceWidth, int sourceHeight, const PaddingOptions& options,
+                            int* width, int* height);
+
+    // Cuts the tiles out of a padded source. Only tile size and padding of
+    // the options are used.
+    static bool removePadding(const PixelView& source, const PixelView& target, const PaddingOptions& options);
+};
+
+#endif // PADDINGENGINE_H
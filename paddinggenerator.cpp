@@ -1,9 +1,14 @@
 #include "paddinggenerator.h"
+#include "trace.h"
 
 #include <QPainter>
+#include <cstring>
 
 PaddingGenerator::PaddingGenerator() {
     target = nullptr;
+    targetBits = nullptr;
+    targetStride = 0;
+    targetFormat = QImage::Format_ARGB32;
     tileWidth = 16;
     tileHeight = 16;
     padding = 1;
@@ -51,16 +56,136 @@ void PaddingGenerator::setBackgroundColor(QColor value) {
 }
 
 QImage* PaddingGenerator::create(QImage* source) {
-    findSizes(source);
+    findSizes(source->size());
     createTargetImage();
     drawTiles(source);
     drawEdges();
     return target;
 }
 
-void PaddingGenerator::findSizes(QImage* source) {
-    cols = source->width() / tileWidth;
-    rows = source->height() / tileHeight;
+QImage* PaddingGenerator::prepare(QImage* source) {
+    findSizes(source->size());
+    createTargetImage();
+    setTarget(target->bits(), target->bytesPerLine(), target->format());
+    return target;
+}
+
+QSize PaddingGenerator::layout(const QSize& sourceSize) {
+    findSizes(sourceSize);
+    return targetSize();
+}
+
+void PaddingGenerator::setTarget(uchar* bits, qsizetype stride, QImage::Format format) {
+    targetBits = bits;
+    targetStride = stride;
+    targetFormat = format;
+}
+
+void PaddingGenerator::clearTarget() const {
+    TraceScope scope("clearTarget");
+    QImage view(targetBits, targetWidth, targetHeight, targetStride, targetFormat);
+    if (transparent) {
+        view.fill(Qt::transparent);
+    } else {
+        view.fill(backgroundColor);
+    }
+}
+
+QSize PaddingGenerator::targetSize() const {
+    return QSize(targetWidth, targetHeight);
+}
+
+int PaddingGenerator::tilesPerRow() const {
+    // drawTiles() wraps a reordered row at the first tile that reaches the last grid column
+    if (!forcePot || !reorder) {
+        return cols;
+    }
+    int perRow = 1;
+    while (padding + perRow * gridWidth < targetWidth - gridWidth) {
+        perRow++;
+    }
+    return perRow;
+}
+
+int PaddingGenerator::bandRowCount() const {
+    return targetHeight / gridHeight;
+}
+
+QRect PaddingGenerator::bandRect(int firstRow, int lastRow) const {
+    // The last band also covers the rows below the grid (PoT remainder)
+    int targetRows = targetHeight / gridHeight;
+    int y0 = firstRow * gridHeight;
+    int y1 = lastRow >= targetRows ? targetHeight : lastRow * gridHeight;
+    return QRect(0, y0, targetWidth, qMax(0, y1 - y0));
+}
+
+void PaddingGenerator::renderBand(const QImage& source, int firstRow, int lastRow) const {
+    int targetRows = targetHeight / gridHeight;
+    int targetCols = targetWidth / gridWidth;
+
+    QRect rect = bandRect(firstRow, lastRow);
+    if (rect.isEmpty()) {
+        return;
+    }
+    int y0 = rect.top();
+    int y1 = y0 + rect.height();
+    int bandHeight = rect.height();
+
+    // A view into the band's rows of the target, each band paints with its own painter
+    QImage band(targetBits + y0 * targetStride, targetWidth, bandHeight, targetStride, targetFormat);
+
+    // Same placement as drawTiles()
+    bool doReorder = forcePot && reorder;
+    int perRow = tilesPerRow();
+    {
+        TraceScope scope("drawTiles");
+        QPainter p(&band);
+        for (int j = 0; j < rows; j++) {
+            for (int i = 0; i < cols; i++) {
+                int index = j * cols + i;
+                int row = doReorder ? index / perRow : j;
+                int col = doReorder ? index % perRow : i;
+                int y = row * gridHeight + padding;
+                if (y >= y1 || y + tileHeight <= y0) {
+                    continue;
+                }
+                p.drawImage(col * gridWidth + padding, y - y0, source, i * tileWidth, j * tileHeight, tileWidth, tileHeight);
+            }
+        }
+    }
+
+    // Same edge extension as drawEdges(), on raw scanlines. Every grid cell
+    // only copies within itself, so bands don't depend on each other.
+    TraceScope scope("drawEdges");
+    uchar* bits = band.bits();
+    qsizetype rowBytes = qsizetype(targetWidth) * 4;
+    int lastGridRow = qMin(lastRow, targetRows);
+    for (int offset = 1; offset < padding + 1; offset++) {
+        for (int j = firstRow; j < lastGridRow; j++) {
+            int y = j * gridHeight + padding - y0;
+            memcpy(bits + (y - offset) * targetStride, bits + y * targetStride, rowBytes);
+            y = j * gridHeight + tileHeight + padding - 1 - y0;
+            memcpy(bits + (y + offset) * targetStride, bits + y * targetStride, rowBytes);
+        }
+    }
+
+    for (int y = 0; y < bandHeight; y++) {
+        QRgb* line = reinterpret_cast<QRgb*>(bits + y * targetStride);
+        for (int j = 0; j < targetCols; j++) {
+            int left = j * gridWidth + padding;
+            int right = j * gridWidth + tileWidth + padding - 1;
+            for (int offset = 1; offset < padding + 1; offset++) {
+                line[left - offset] = line[left];
+                line[right + offset] = line[right];
+            }
+        }
+    }
+}
+
+void PaddingGenerator::findSizes(const QSize& sourceSize) {
+    TraceScope scope("findSizes");
+    cols = sourceSize.width() / tileWidth;
+    rows = sourceSize.height() / tileHeight;
     gridWidth = tileWidth + padding * 2;
     gridHeight = tileHeight + padding * 2;
     targetWidth = cols * gridWidth;
@@ -88,6 +213,7 @@ void PaddingGenerator::findSizes(QImage* source) {
 }
 
 void PaddingGenerator::createTargetImage() {
+    TraceScope scope("createTarget");
     if (target != nullptr) {
         delete target;
     }
@@ -100,6 +226,7 @@ void PaddingGenerator::createTargetImage() {
 }
 
 void PaddingGenerator::drawTiles(QImage* source) {
+    TraceScope scope("drawTiles");
     int x = padding;
     int y = padding;
     int sx = 0;
@@ -126,6 +253,7 @@ void PaddingGenerator::drawTiles(QImage* source) {
 }
 
 void PaddingGenerator::drawEdges() {
+    TraceScope scope("drawEdges");
     cols = targetWidth / gridWidth;
     rows = targetHeight / gridHeight;
     int y;
@@ -17,6 +17,24 @@ public:
     void setBackgroundColor(QColor value);
     QImage* create(QImage* source);
 
+    // Band rendering lets one large sheet be split across threads: prepare()
+    // sizes and allocates the target, then each range of target grid rows can
+    // be rendered independently (and concurrently) with renderBand().
+    QImage* prepare(QImage* source);
+
+    // The same for a target owned by the caller: layout() sizes the target for
+    // a source of the given size, setTarget() points the bands at a buffer of
+    // targetSize() pixels and clearTarget() fills it with the background.
+    QSize layout(const QSize& sourceSize);
+    void setTarget(uchar* bits, qsizetype stride, QImage::Format format);
+    void clearTarget() const;
+
+    QSize targetSize() const;
+    int tilesPerRow() const;
+    int bandRowCount() const;
+    QRect bandRect(int firstRow, int lastRow) const;
+    void renderBand(const QImage& source, int firstRow, int lastRow) const;
+
 private:
     int tileWidth;
     int tileHeight;
@@ -31,9 +49,12 @@ private:
     int targetWidth;
     int targetHeight;
     QImage* target;
+    uchar* targetBits;
+    qsizetype targetStride;
+    QImage::Format targetFormat;
     QColor backgroundColor;
 
-    void findSizes(QImage* source);
+    void findSizes(const QSize& sourceSize);
     void createTargetImage();
     void drawTiles(QImage* source);
     void drawEdges();
@@ -24,23 +24,35 @@ QImage* PaddingRemover::create(QImage* source) {
     if (target != nullptr) {
         delete target;
     }
+    target = new QImage(targetSize(source->size()), QImage::Format_ARGB32);
+    render(*source, *target);
+    return target;
+}
+
+QSize PaddingRemover::targetSize(const QSize& sourceSize) const {
+    int cols = sourceSize.width() / (tileWidth + padding * 2);
+    int rows = sourceSize.height() / (tileHeight + padding * 2);
+    return QSize(cols * tileWidth, rows * tileHeight);
+}
+
+void PaddingRemover::render(const QImage& source, QImage& target) const {
     int gridWidth = tileWidth + padding * 2;
     int gridHeight = tileHeight + padding * 2;
-    int cols = source->width() / gridWidth;
-    int rows = source->height() / gridHeight;
-    int targetWidth = cols * tileWidth;
-    int targetHeight = rows * tileHeight;
+    int cols = target.width() / tileWidth;
+    int rows = target.height() / tileHeight;
     int sx;
     int sy = padding;
-    target = new QImage(targetWidth, targetHeight, QImage::Format_ARGB32);
-    QPainter p(target);
+    if (target.isNull()) {
+        return;
+    }
+    target.fill(Qt::transparent);
+    QPainter p(&target);
     for (int j = 0; j < rows; j++) {
         sx = padding;
         for (int i = 0; i < cols; i++) {
-            p.drawImage(i * tileWidth, j * tileHeight, *source, sx, sy, tileWidth, tileHeight);
+            p.drawImage(i * tileWidth, j * tileHeight, source, sx, sy, tileWidth, tileHeight);
             sx += gridWidth;
         }
         sy += gridHeight;
     }
-    return target;
 }
@@ -13,6 +13,11 @@ public:
     void setPadding(int value);
     QImage* create(QImage* source);
 
+    // For a target owned by the caller: the size it needs for a source of the
+    // given size, and drawing the tiles into it
+    QSize targetSize(const QSize& sourceSize) const;
+    void render(const QImage& source, QImage& target) const;
+
 private:
     int tileWidth;
     int tileHeight;
@@ -4,23 +4,52 @@
 #include <QPainter>
 #include <QMimeData>
 #include <QFont>
+#include <QtMath>
+
+#include <cmath>
+
+// Pixmaps up to this size are scaled on the fly, larger ones get a pyramid
+static const int MinPyramidSize = 1024;
+
+// Edge of a cached preview tile in device pixels
+static const int PreviewTileSize = 256;
+
+static const double ZoomSteps[] = {
+    1.0 / 32, 1.0 / 16, 1.0 / 8, 1.0 / 4, 1.0 / 3, 1.0 / 2, 2.0 / 3,
+    1, 2, 3, 4, 6, 8, 12, 16, 24, 32
+};
 
 PixmapDropWidget::PixmapDropWidget(QWidget *parent) : QWidget(parent) {
     setAcceptDrops(true);
-    pixmap = new QPixmap();
     rebuildCheckerboard();
+    m_pyramids.setMaxCost(128 * 1024); // KB
+    m_pyramidPool.setMaxThreadCount(1);
+    m_tiles.setMaxCost(64 * 1024); // KB
 }
 
 PixmapDropWidget::~PixmapDropWidget() {
-    delete pixmap;
+    m_pyramidPool.clear();
+    m_pyramidPool.waitForDone();
 }
 
-QPixmap* PixmapDropWidget::getPixmap() {
-    return pixmap;
+const QPixmap& PixmapDropWidget::pixmap() const {
+    return m_pixmap;
 }
 
-void PixmapDropWidget::setPixmap(QPixmap* value) {
-    pixmap = value;
+void PixmapDropWidget::setPixmap(const QPixmap& pixmap) {
+    // Shares the data with the caller, nothing is copied
+    m_pixmap = pixmap;
+    requestPyramid();
+    update();
+}
+
+void PixmapDropWidget::drawImage(const QPoint& offset, const QImage& image) {
+    // Detaches from the shared data only if someone else still holds it
+    QPainter p(&m_pixmap);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.drawImage(offset, image);
+    p.end();
+    update();
 }
 
 void PixmapDropWidget::setDarkMode(bool dark) {
@@ -34,6 +63,187 @@ void PixmapDropWidget::setReferenceSize(QSize size) {
     update();
 }
 
+void PixmapDropWidget::setView(double zoom, QPointF pan) {
+    m_zoom = zoom;
+    m_pan = pan;
+    update();
+}
+
+double PixmapDropWidget::currentScale() const {
+    if (m_zoom > 0) {
+        return m_zoom;
+    }
+    // Same scale for source and result: the reference size fits the widget
+    QSize reference = m_referenceSize;
+    if (!reference.isValid() || reference.isEmpty()) {
+        reference = m_pixmap.size();
+    }
+    QSize referenceFit = reference.scaled(size(), Qt::KeepAspectRatio);
+    return (double)referenceFit.width() / (double)reference.width();
+}
+
+QRect PixmapDropWidget::visibleImageRect() const {
+    // The part of the image inside the widget, in image pixels
+    if (m_pixmap.isNull()) {
+        return QRect();
+    }
+    double scale = currentScale();
+    QPointF origin = imageOrigin(scale);
+    QRectF visible(-origin / scale, QSizeF(width() / scale, height() / scale));
+    return visible.toAlignedRect().intersected(m_pixmap.rect());
+}
+
+QPointF PixmapDropWidget::imageOrigin(double scale) const {
+    // Image center = widget center, moved by the pan
+    double x = width() / 2.0 - (m_pixmap.width() / 2.0 + m_pan.x()) * scale;
+    double y = height() / 2.0 - (m_pixmap.height() / 2.0 + m_pan.y()) * scale;
+    return QPointF(qRound(x), qRound(y));
+}
+
+void PixmapDropWidget::drawVisibleTiles(QPainter& p, double scale) {
+    // Tiles are square in device pixels. When magnified they cover a whole
+    // number of image pixels, so nearest sampling stays pixel exact.
+    double dpr = devicePixelRatioF();
+    double deviceScale = scale * dpr;
+    double tileImageSize = PreviewTileSize / deviceScale;
+    if (deviceScale >= 1) {
+        tileImageSize = qMax(1.0, std::floor(tileImageSize));
+    }
+    double tileWidgetSize = tileImageSize * scale;
+
+    // Only the tiles intersecting the widget are rendered and drawn
+    QPointF origin = imageOrigin(scale);
+    QRectF imageRect(origin, QSizeF(m_pixmap.width() * scale, m_pixmap.height() * scale));
+    QRectF visible = imageRect.intersected(QRectF(rect()));
+    if (visible.isEmpty()) {
+        return;
+    }
+    int firstX = int((visible.left() - origin.x()) / tileWidgetSize);
+    int firstY = int((visible.top() - origin.y()) / tileWidgetSize);
+    int lastX = int((visible.right() - origin.x()) / tileWidgetSize);
+    int lastY = int((visible.bottom() - origin.y()) / tileWidgetSize);
+
+    QRectF imageBounds(0, 0, m_pixmap.width(), m_pixmap.height());
+    for (int ty = firstY; ty <= lastY; ty++) {
+        for (int tx = firstX; tx <= lastX; tx++) {
+            QRectF sourceRect = QRectF(tx * tileImageSize, ty * tileImageSize, tileImageSize, tileImageSize)
+                .intersected(imageBounds);
+            if (sourceRect.isEmpty()) {
+                continue;
+            }
+            PreviewTileKey key { m_pixmap.cacheKey(), deviceScale, tx, ty };
+            QPixmap* tile = m_tiles.object(key);
+            if (!tile) {
+                tile = new QPixmap(renderTile(sourceRect, scale));
+                m_tiles.insert(key, tile, qMax<qint64>(1, qint64(tile->width()) * tile->height() * 4 / 1024));
+                tile = m_tiles.object(key);
+            }
+            if (tile) {
+                p.drawPixmap(origin + QPointF(tx * tileWidgetSize, ty * tileWidgetSize), *tile);
+            }
+        }
+    }
+}
+
+QPixmap PixmapDropWidget::renderTile(const QRectF& sourceRect, double scale) const {
+    double dpr = devicePixelRatioF();
+    QSizeF tileSize = sourceRect.size() * scale;
+    QPixmap tile(qCeil(tileSize.width() * dpr), qCeil(tileSize.height() * dpr));
+    tile.setDevicePixelRatio(dpr);
+    tile.fill(Qt::transparent);
+
+    QPainter p(&tile);
+    if (scale * dpr >= 1) {
+        // Magnified: nearest sampling shows the real pixels
+        p.drawPixmap(QRectF(QPointF(0, 0), tileSize), m_pixmap, sourceRect);
+    } else {
+        // Minified: filter from the closest pyramid level
+        QSize drawSize(qRound(m_pixmap.width() * scale), qRound(m_pixmap.height() * scale));
+        const QPixmap& level = levelFor(drawSize);
+        double levelFactor = (double)level.width() / (double)m_pixmap.width();
+        QRectF levelRect(sourceRect.topLeft() * levelFactor, sourceRect.size() * levelFactor);
+        p.setRenderHint(QPainter::SmoothPixmapTransform);
+        p.drawPixmap(QRectF(QPointF(0, 0), tileSize), level, levelRect);
+    }
+    p.end();
+    return tile;
+}
+
+void PixmapDropWidget::wheelEvent(QWheelEvent* event) {
+    if (m_pixmap.isNull() || event->angleDelta().y() == 0) {
+        QWidget::wheelEvent(event);
+        return;
+    }
+    double scale = currentScale();
+    double newScale = scale;
+    if (event->angleDelta().y() > 0) {
+        for (double step : ZoomSteps) {
+            if (step > scale * 1.0001) {
+                newScale = step;
+                break;
+            }
+        }
+    } else {
+        for (double step : ZoomSteps) {
+            if (step < scale * 0.9999) {
+                newScale = step;
+            }
+        }
+    }
+
+    // Keep the image point under the cursor in place
+    QPointF cursor = event->position();
+    QPointF imagePoint = (cursor - imageOrigin(scale)) / scale;
+    QPointF center(width() / 2.0, height() / 2.0);
+    m_zoom = newScale;
+    m_pan = (center - cursor) / newScale + imagePoint - QPointF(m_pixmap.width() / 2.0, m_pixmap.height() / 2.0);
+    update();
+    emit viewChanged(m_zoom, m_pan);
+    event->accept();
+}
+
+void PixmapDropWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton || m_pixmap.isNull()) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    m_panning = true;
+    m_lastMousePos = event->position();
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void PixmapDropWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (!m_panning) {
+        QWidget::mouseMoveEvent(event);
+        return;
+    }
+    // Panning keeps the current scale, even if it was the fitted one
+    double scale = currentScale();
+    m_zoom = scale;
+    m_pan -= (event->position() - m_lastMousePos) / scale;
+    m_lastMousePos = event->position();
+    update();
+    emit viewChanged(m_zoom, m_pan);
+}
+
+void PixmapDropWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (!m_panning) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+    m_panning = false;
+    unsetCursor();
+}
+
+void PixmapDropWidget::mouseDoubleClickEvent(QMouseEvent* event) {
+    Q_UNUSED(event);
+    // Back to fitting the whole image
+    m_zoom = 0;
+    m_pan = QPointF();
+    update();
+    emit viewChanged(m_zoom, m_pan);
+}
+
 void PixmapDropWidget::rebuildCheckerboard() {
     const int cellSize = 8;
     m_checkerboard = QPixmap(cellSize * 2, cellSize * 2);
@@ -55,7 +265,6 @@ void PixmapDropWidget::rebuildCheckerboard() {
 void PixmapDropWidget::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event);
     QPainter p(this);
-    p.setRenderHint(QPainter::SmoothPixmapTransform);
 
     // Draw checkerboard background
     if (!m_checkerboard.isNull()) {
@@ -64,21 +273,15 @@ void PixmapDropWidget::paintEvent(QPaintEvent* event) {
         p.fillRect(rect(), QColor("#333333"));
     }
 
-    if (pixmap && !pixmap->isNull()) {
-        if (m_referenceSize.isValid() && !m_referenceSize.isEmpty()) {
-            // Same scale for source and result, image center = widget center
-            QSize refFit = m_referenceSize.scaled(size(), Qt::KeepAspectRatio);
-            double scale = (double)refFit.width() / (double)m_referenceSize.width();
-            int drawW = (int)(pixmap->width() * scale);
-            int drawH = (int)(pixmap->height() * scale);
-            int x = (width() - drawW) / 2;
-            int y = (height() - drawH) / 2;
-            p.drawPixmap(x, y, drawW, drawH, *pixmap);
-        } else {
-            QSize scaledSize = pixmap->size().scaled(size(), Qt::KeepAspectRatio);
-            int x = (width() - scaledSize.width()) / 2;
-            int y = (height() - scaledSize.height()) / 2;
-            p.drawPixmap(x, y, scaledSize.width(), scaledSize.height(), *pixmap);
+    if (!m_pixmap.isNull()) {
+        double scale = currentScale();
+        drawVisibleTiles(p, scale);
+
+        if (m_zoom > 0) {
+            QColor textColor = m_darkMode ? QColor("#e0e0e0") : QColor("#333333");
+            p.setPen(textColor);
+            p.drawText(rect().adjusted(8, 8, -8, -8), Qt::AlignLeft | Qt::AlignBottom,
+                       QString("%1%").arg(qRound(scale * 100)));
         }
     } else {
         // Draw drop zone indicator
@@ -145,7 +348,83 @@ void PixmapDropWidget::dropEvent(QDropEvent* event) {
 }
 
 bool PixmapDropWidget::load(QString path) {
-    pixmap->load(path);
+    m_pixmap.load(path);
+    requestPyramid();
     update();
-    return !pixmap->isNull();
+    return !m_pixmap.isNull();
+}
+
+qint64 PixmapDropWidget::previewBytes() const {
+    return (m_pyramids.totalCost() + m_tiles.totalCost()) * 1024;
+}
+
+void PixmapDropWidget::clearPreviews() {
+    m_pyramids.clear();
+    m_tiles.clear();
+    // The shown pixmap gets its levels back
+    requestPyramid();
+    update();
+}
+
+void PixmapDropWidget::requestPyramid() {
+    if (m_pixmap.isNull()) {
+        return;
+    }
+    if (m_pixmap.width() <= MinPyramidSize && m_pixmap.height() <= MinPyramidSize) {
+        return;
+    }
+    qint64 key = m_pixmap.cacheKey();
+    if (m_pyramids.contains(key) || key == m_pendingPyramidKey) {
+        return;
+    }
+
+    // Only the latest pixmap matters, drop builds that haven't started yet
+    m_pyramidPool.clear();
+    m_pendingPyramidKey = key;
+    QImage image = m_pixmap.toImage();
+    m_pyramidPool.start([this, key, image]() {
+        QList<QImage> images;
+        QImage level = image;
+        while (level.width() > MinPyramidSize / 2 || level.height() > MinPyramidSize / 2) {
+            level = level.scaled(qMax(1, level.width() / 2), qMax(1, level.height() / 2),
+                                 Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            images.append(level);
+        }
+        QMetaObject::invokeMethod(this, [this, key, images]() {
+            pyramidReady(key, images);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void PixmapDropWidget::pyramidReady(qint64 key, const QList<QImage>& images) {
+    if (key == m_pendingPyramidKey) {
+        m_pendingPyramidKey = 0;
+    }
+    auto levels = new QList<QPixmap>();
+    qint64 bytes = 0;
+    for (const QImage& image : images) {
+        levels->append(QPixmap::fromImage(image));
+        bytes += image.sizeInBytes();
+    }
+    m_pyramids.insert(key, levels, qMax<qint64>(1, bytes / 1024));
+    if (m_pixmap.cacheKey() == key) {
+        update();
+    }
+}
+
+const QPixmap& PixmapDropWidget::levelFor(QSize drawSize) const {
+    const QList<QPixmap>* levels = m_pyramids.object(m_pixmap.cacheKey());
+    if (!levels) {
+        return m_pixmap;
+    }
+    // The smallest level still at least as large as the drawn size, so it is only ever scaled down
+    QSize deviceSize = drawSize * devicePixelRatioF();
+    const QPixmap* best = &m_pixmap;
+    for (const QPixmap& level : *levels) {
+        if (level.width() < deviceSize.width() || level.height() < deviceSize.height()) {
+            break;
+        }
+        best = &level;
+    }
+    return *best;
 }
@@ -8,6 +8,26 @@
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
 #include <QDropEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QCache>
+#include <QThreadPool>
+
+// Identifies a rendered tile of the visible region at one scale
+struct PreviewTileKey {
+    qint64 pixmapKey;
+    double scale;
+    int x;
+    int y;
+};
+
+inline bool operator==(const PreviewTileKey& a, const PreviewTileKey& b) {
+    return a.pixmapKey == b.pixmapKey && a.scale == b.scale && a.x == b.x && a.y == b.y;
+}
+
+inline size_t qHash(const PreviewTileKey& key, size_t seed = 0) {
+    return qHashMulti(seed, key.pixmapKey, key.scale, key.x, key.y);
+}
 
 class PixmapDropWidget : public QWidget
 {
@@ -16,13 +36,29 @@ public:
     explicit PixmapDropWidget(QWidget *parent = nullptr);
     ~PixmapDropWidget() override;
     bool load(QString path);
-    QPixmap* getPixmap();
-    void setPixmap(QPixmap* pixmap);
+    const QPixmap& pixmap() const;
+    void setPixmap(const QPixmap& pixmap);
+    void drawImage(const QPoint& offset, const QImage& image);
     void setDarkMode(bool dark);
     void setReferenceSize(QSize size);
+    QRect visibleImageRect() const;
+
+    // Memory of the downscaled levels and rendered tiles kept for drawing
+    qint64 previewBytes() const;
+    void clearPreviews();
+
+public slots:
+    // Zoom 0 fits the reference size into the widget. Pan is the offset of the
+    // view center from the image center, in image pixels.
+    void setView(double zoom, QPointF pan);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
     void dragEnterEvent(QDragEnterEvent* event) override;
     void dragLeaveEvent(QDragLeaveEvent* event) override;
     void dropEvent(QDropEvent* event) override;
@@ -30,15 +66,34 @@ protected:
 signals:
     void dropSignal(QString path);
     void filesDropped(QStringList paths);
+    void viewChanged(double zoom, QPointF pan);
 
 private:
     void rebuildCheckerboard();
+    void requestPyramid();
+    void pyramidReady(qint64 key, const QList<QImage>& images);
+    const QPixmap& levelFor(QSize drawSize) const;
+    double currentScale() const;
+    QPointF imageOrigin(double scale) const;
+    void drawVisibleTiles(QPainter& p, double scale);
+    QPixmap renderTile(const QRectF& sourceRect, double scale) const;
 
-    QPixmap* pixmap;
+    QPixmap m_pixmap;
     bool m_dragHover = false;
     bool m_darkMode = true;
     QPixmap m_checkerboard;
     QSize m_referenceSize;
+
+    // Downscaled copies of large pixmaps (halves, largest first), keyed by QPixmap::cacheKey()
+    QCache<qint64, QList<QPixmap>> m_pyramids;
+    QThreadPool m_pyramidPool;
+    qint64 m_pendingPyramidKey = 0;
+
+    double m_zoom = 0;
+    QPointF m_pan;
+    bool m_panning = false;
+    QPointF m_lastMousePos;
+    QCache<PreviewTileKey, QPixmap> m_tiles;
 };
 
 #endif // PIXMAPWIDGET_H
@@ -0,0 +1,456 @@
+#include "processingworker.h"
+#include "tileprocessor.h"
+#include "trace.h"
+#include "runstats.h"
+
+#include <QMutexLocker>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+// Later stages run first, so files already in flight drain before new ones are decoded
+static const int DecodePriority = 0;
+static const int PadPriority = 1;
+static const int EncodePriority = 2;
+
+// Sheets with at least this many target pixels are split into row bands
+static const qint64 BandPixelThreshold = 2048 * 2048;
+
+struct ProcessingWorker::JobState {
+    ProcessingJob job;
+    quint64 serial = 0;
+    quint64 batch = 0;
+    bool delivered = true;
+    ProcessingResult result;
+    PaddingGenerator generator;
+    QImage* target = nullptr;
+    std::atomic<int> bandsLeft{0};
+    QElapsedTimer padTimer;
+    std::atomic<qint64> padCpuNs{0}; // Added up by the bands
+    QByteArray cacheKey; // Disk cache entry the export is stored under
+    QByteArray cachedExport; // A hit of a job that still pads, written instead of encoding
+
+    // What this job adds to ProcessingWorker::memoryBytes(), given back when the state goes away
+    std::shared_ptr<std::atomic<qint64>> memoryCounter;
+    qint64 memoryBytes = 0;
+
+    void account(qint64 bytes) {
+        memoryBytes += bytes;
+        *memoryCounter += bytes;
+    }
+
+    ~JobState() {
+        if (memoryCounter) {
+            *memoryCounter -= memoryBytes;
+        }
+    }
+};
+
+static double elapsedMs(const QElapsedTimer& timer) {
+    return timer.nsecsElapsed() / 1000000.0;
+}
+
+static double cpuMsSince(qint64 startNs) {
+    return (RunStats::threadCpuNs() - startNs) / 1000000.0;
+}
+
+// Label of the job's span in the trace
+static QString traceName(const ProcessingJob& job) {
+    QString path = job.sourcePath.isEmpty() ? job.exportPath : job.sourcePath;
+    return path.isEmpty() ? QString("File %1").arg(job.fileId) : QFileInfo(path).fileName();
+}
+
+ProcessingWorker::ProcessingWorker(QObject* parent) : QObject(parent) {
+}
+
+ProcessingWorker::~ProcessingWorker() {
+    m_batch++;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void ProcessingWorker::setMaxThreadCount(int count) {
+    m_pool.setMaxThreadCount(count);
+}
+
+void ProcessingWorker::setDiskCache(DiskCache* cache) {
+    m_diskCache = cache;
+}
+
+int ProcessingWorker::maxThreadCount() const {
+    return m_pool.maxThreadCount();
+}
+
+qint64 ProcessingWorker::memoryBytes() const {
+    return *m_memoryBytes;
+}
+
+void ProcessingWorker::submit(const ProcessingJob& job) {
+    auto state = std::make_shared<JobState>();
+    state->job = job;
+    state->result.fileId = job.fileId;
+    state->result.settings = job.settings;
+    state->result.decodeOnly = job.decodeOnly;
+    state->batch = m_batch;
+    state->memoryCounter = m_memoryBytes;
+    state->account(job.source.sizeInBytes() + job.padded.sizeInBytes());
+    {
+        QMutexLocker locker(&m_mutex);
+        state->serial = m_nextSerial++;
+        if (!job.decodeOnly) {
+            m_latestSerial[job.fileId] = state->serial;
+            m_jobsPerFile[job.fileId]++;
+        }
+    }
+    // The name costs a QFileInfo, only built while recording
+    if (Trace::isEnabled()) {
+        Trace::beginJob(state->serial, job.fileId, traceName(job));
+    }
+    m_queue.enqueue(state);
+    m_total++;
+    emit progressChanged(m_done, m_total);
+    feed();
+}
+
+void ProcessingWorker::feed() {
+    // Bounded in-flight count: a file is only decoded when one of the
+    // files ahead of it has been written
+    int maxInFlight = qMax(2, m_pool.maxThreadCount() * 2);
+    while (m_inFlight < maxInFlight && !m_queue.isEmpty()) {
+        auto state = m_queue.dequeue();
+        m_inFlight++;
+        m_pool.start([this, state]() { decode(state); }, DecodePriority);
+    }
+}
+
+void ProcessingWorker::cancel() {
+    m_pool.clear();
+    m_queue.clear();
+    // Stages already running see the batch change and stop, their results are dropped
+    m_batch++;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_latestSerial.clear();
+        m_jobsPerFile.clear();
+    }
+    bool wasBusy = m_total > 0;
+    m_inFlight = 0;
+    m_total = 0;
+    m_done = 0;
+    if (wasBusy) {
+        emit finished(true);
+    }
+}
+
+void ProcessingWorker::supersede(quint64 fileId) {
+    // Jobs still running for the file finish without delivering their result
+    QMutexLocker locker(&m_mutex);
+    if (m_jobsPerFile.value(fileId) > 0) {
+        m_latestSerial[fileId] = m_nextSerial++;
+    } else {
+        m_latestSerial.remove(fileId);
+    }
+}
+
+bool ProcessingWorker::isBusy() const {
+    return m_total > 0;
+}
+
+bool ProcessingWorker::isCancelled(const JobStatePtr& state) const {
+    return state->batch != m_batch;
+}
+
+bool ProcessingWorker::isSuperseded(quint64 fileId, quint64 serial) const {
+    QMutexLocker locker(&m_mutex);
+    return m_latestSerial.value(fileId) != serial;
+}
+
+void ProcessingWorker::decode(const JobStatePtr& state) {
+    if (isCancelled(state)) {
+        return;
+    }
+    // A newer job for the same file makes this one pointless
+    if (!state->job.decodeOnly && isSuperseded(state->job.fileId, state->serial)) {
+        state->delivered = false;
+        finish(state);
+        return;
+    }
+    if (!state->job.padded.isNull()) {
+        state->result.image = state->job.padded;
+        state->result.sourceKey = state->job.sourceKey;
+        state->job.padded = QImage();
+        m_pool.start([this, state]() { encode(state); }, EncodePriority);
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    qint64 cpuStart = RunStats::threadCpuNs();
+
+    // With a disk cache the source file is read once: its bytes are the cache
+    // key, and on a miss they are decoded from memory
+    quint64 fileId = state->job.fileId;
+    QByteArray sourceData;
+    if (m_diskCache && !state->job.exportPath.isEmpty() && !state->job.sourcePath.isEmpty()) {
+        {
+            TraceScope scope("readSource", fileId);
+            QFile file(state->job.sourcePath);
+            if (file.open(QIODevice::ReadOnly)) {
+                sourceData = file.readAll();
+            }
+        }
+        if (!sourceData.isEmpty()) {
+            QByteArray cached;
+            bool hit;
+            {
+                TraceScope scope("cacheLookup", fileId);
+                state->cacheKey = DiskCache::key(sourceData, state->job.settings,
+                    ImageWriter::formatForPath(state->job.exportPath));
+                hit = m_diskCache->find(state->cacheKey, &cached);
+            }
+            // The GUI keeps the padded image and exports it again later, so it
+            // pads from the source: a decoded export (JPG) isn't the result
+            if (hit && state->job.keepImage) {
+                state->cachedExport = cached;
+                state->account(cached.size());
+                state->result.cached = true;
+            } else if (hit) {
+                exportCached(state, sourceData, cached);
+                state->result.decodeMs = elapsedMs(timer);
+                state->result.decodeCpuMs = cpuMsSince(cpuStart);
+                finish(state);
+                return;
+            }
+        }
+    }
+
+    if (state->job.source.isNull()) {
+        TraceScope scope("decode", fileId);
+        state->job.source = sourceData.isEmpty() ? QImage(state->job.sourcePath) : QImage::fromData(sourceData);
+        if (state->job.source.isNull()) {
+            state->result.error = "Could not load image: " + state->job.sourcePath;
+            finish(state);
+            return;
+        }
+        if (state->job.keepImage) {
+            // The GUI shows it, the CLI only needs the file written
+            state->result.source = state->job.source;
+        }
+        state->account(state->job.source.sizeInBytes());
+        state->result.bytesRead = sourceData.isEmpty() ? QFileInfo(state->job.sourcePath).size() : sourceData.size();
+    }
+    state->result.sourceSize = state->job.source.size();
+    if (state->job.sourceKey == 0 && state->job.keepImage) {
+        TraceScope scope("sourceKey", fileId);
+        state->job.sourceKey = TileProcessor::sourceKey(state->job.source);
+    }
+    state->result.sourceKey = state->job.sourceKey;
+    state->result.decodeMs = elapsedMs(timer);
+    state->result.decodeCpuMs = cpuMsSince(cpuStart);
+    if (state->job.decodeOnly) {
+        finish(state);
+        return;
+    }
+    m_pool.start([this, state]() { pad(state); }, PadPriority);
+}
+
+void ProcessingWorker::pad(const JobStatePtr& state) {
+    if (isCancelled(state)) {
+        return;
+    }
+    state->padTimer.start();
+    qint64 cpuStart = RunStats::threadCpuNs();
+    const ProjectSettings& settings = state->job.settings;
+    if (settings.removePadding) {
+        TraceScope scope("removePadding", state->job.fileId);
+        state->result.image = TileProcessor::process(state->job.source, settings);
+        state->account(state->result.image.sizeInBytes());
+        state->result.padMs = elapsedMs(state->padTimer);
+        state->result.padCpuMs = cpuMsSince(cpuStart);
+        m_pool.start([this, state]() { encode(state); }, EncodePriority);
+        return;
+    }
+
+    {
+        TraceScope scope("prepare", state->job.fileId);
+        TileProcessor::configure(state->generator, settings);
+        state->target = state->generator.prepare(&state->job.source);
+    }
+    state->account(state->target->sizeInBytes());
+    state->padCpuNs = RunStats::threadCpuNs() - cpuStart;
+
+    int rowCount = state->generator.bandRowCount();
+    qint64 pixels = qint64(state->target->width()) * state->target->height();
+    int bands = 1;
+    if (pixels >= BandPixelThreshold) {
+        bands = qBound(1, rowCount, m_pool.maxThreadCount() * 2);
+    }
+    bool progressive = state->job.progressive && bands > 1;
+
+    // Bands nearest to the priority row go to the pool first
+    QList<QPair<int, int>> ranges;
+    for (int b = 0; b < bands; b++) {
+        ranges.append(qMakePair(rowCount * b / bands, rowCount * (b + 1) / bands));
+    }
+    if (rowCount > 0 && state->target->height() > 0) {
+        int priorityRow = qBound(0, state->job.priorityY * rowCount / state->target->height(), rowCount - 1);
+        std::stable_sort(ranges.begin(), ranges.end(), [priorityRow](const QPair<int, int>& a, const QPair<int, int>& b) {
+            auto distance = [priorityRow](const QPair<int, int>& range) {
+                if (priorityRow < range.first) {
+                    return range.first - priorityRow;
+                }
+                if (priorityRow >= range.second) {
+                    return priorityRow - range.second + 1;
+                }
+                return 0;
+            };
+            return distance(a) < distance(b);
+        });
+    }
+    state->bandsLeft = bands;
+
+    // The last band to finish hands the file to the encode stage
+    for (const auto& range : ranges) {
+        int firstRow = range.first;
+        int lastRow = range.second;
+        m_pool.start([this, state, firstRow, lastRow, progressive]() {
+            if (!isCancelled(state) && !isSuperseded(state->job.fileId, state->serial)) {
+                TraceScope scope("band", state->job.fileId);
+                qint64 bandCpuStart = RunStats::threadCpuNs();
+                state->generator.renderBand(state->job.source, firstRow, lastRow);
+                if (progressive) {
+                    deliverBand(state, state->generator.bandRect(firstRow, lastRow));
+                }
+                state->padCpuNs += RunStats::threadCpuNs() - bandCpuStart;
+            }
+            if (--state->bandsLeft == 0) {
+                state->result.image = *state->target;
+                state->result.padMs = elapsedMs(state->padTimer);
+                state->result.padCpuMs = state->padCpuNs / 1000000.0;
+                m_pool.start([this, state]() { encode(state); }, EncodePriority);
+            }
+        }, PadPriority);
+    }
+}
+
+void ProcessingWorker::deliverBand(const JobStatePtr& state, const QRect& rect) {
+    TraceScope scope("copyBand", state->job.fileId);
+    QImage band = state->target->copy(rect);
+    QSize targetSize = state->target->size();
+    QMetaObject::invokeMethod(this, [this, state, targetSize, rect, band]() {
+        if (isCancelled(state) || isSuperseded(state->job.fileId, state->serial)) {
+            return;
+        }
+        emit bandProcessed(state->job.fileId, targetSize, rect.topLeft(), band);
+    }, Qt::QueuedConnection);
+}
+
+void ProcessingWorker::encode(const JobStatePtr& state) {
+    if (isCancelled(state)) {
+        return;
+    }
+    state->delivered = !isSuperseded(state->job.fileId, state->serial);
+    state->result.outputSize = state->result.image.size();
+    if (state->delivered && !state->job.exportPath.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+        qint64 cpuStart = RunStats::threadCpuNs();
+        state->result.exported = true;
+        state->result.exportStamp = state->job.exportStamp;
+        quint64 fileId = state->job.fileId;
+        QByteArray data = state->cachedExport;
+        state->cachedExport = QByteArray();
+        state->account(-data.size());
+        bool cached = !data.isEmpty();
+        if (!cached) {
+            TraceScope scope("encode", fileId);
+            data = ImageWriter::encode(state->result.image, ImageWriter::formatForPath(state->job.exportPath));
+        }
+        state->account(data.size());
+        if (data.isEmpty()) {
+            state->result.exportResult = ImageWriter::Result::Failed;
+        } else {
+            {
+                TraceScope scope("write", fileId);
+                state->result.exportResult = ImageWriter::writeData(data, state->job.exportPath, &state->result.exportStamp);
+            }
+            state->result.outputBytes = data.size();
+            if (state->result.exportResult == ImageWriter::Result::Written) {
+                state->result.bytesWritten = data.size();
+            }
+            if (m_diskCache && !state->cacheKey.isEmpty() && !cached) {
+                TraceScope scope("cacheInsert", fileId);
+                m_diskCache->insert(state->cacheKey, data);
+            }
+        }
+        state->account(-data.size());
+        state->result.encodeMs = elapsedMs(timer);
+        state->result.encodeCpuMs = cpuMsSince(cpuStart);
+    }
+    if (!state->job.keepImage) {
+        state->result.image = QImage();
+    }
+    finish(state);
+}
+
+void ProcessingWorker::exportCached(const JobStatePtr& state, const QByteArray& sourceData, const QByteArray& data) {
+    state->delivered = !isSuperseded(state->job.fileId, state->serial);
+    if (!state->delivered) {
+        return;
+    }
+    TraceScope scope("writeCached", state->job.fileId);
+    state->result.cached = true;
+    state->result.exported = true;
+    state->result.exportStamp = state->job.exportStamp;
+    state->result.exportResult = ImageWriter::writeData(data, state->job.exportPath, &state->result.exportStamp);
+    state->result.bytesRead = sourceData.size();
+    state->result.outputBytes = data.size();
+    if (state->result.exportResult == ImageWriter::Result::Written) {
+        state->result.bytesWritten = data.size();
+    }
+    state->result.sourceSize = RunStats::encodedSize(sourceData);
+    state->result.outputSize = RunStats::encodedSize(data);
+}
+
+void ProcessingWorker::finish(const JobStatePtr& state) {
+    // The job's source isn't needed anymore. Unless result.source shares it
+    // (keepImage jobs that decoded it), it is freed before the result waits
+    // in the event queue.
+    state->account(-state->job.source.sizeInBytes());
+    state->job.source = QImage();
+    QMetaObject::invokeMethod(this, [this, state]() {
+        jobDone(state);
+    }, Qt::QueuedConnection);
+}
+
+void ProcessingWorker::jobDone(const JobStatePtr& state) {
+    if (isCancelled(state)) {
+        return;
+    }
+    if (Trace::isEnabled()) {
+        Trace::endJob(state->serial, state->job.fileId, traceName(state->job));
+    }
+    {
+        // The last job of a file forgets it, also when it was superseded.
+        // --serve and --watch use a new file id per job.
+        QMutexLocker locker(&m_mutex);
+        auto jobs = m_jobsPerFile.find(state->job.fileId);
+        if (!state->job.decodeOnly && jobs != m_jobsPerFile.end() && --jobs.value() == 0) {
+            m_jobsPerFile.erase(jobs);
+            m_latestSerial.remove(state->job.fileId);
+        }
+    }
+    m_inFlight--;
+    m_done++;
+    if (state->delivered) {
+        emit fileProcessed(state->result);
+    }
+    emit progressChanged(m_done, m_total);
+    feed();
+    if (m_done >= m_total) {
+        m_total = 0;
+        m_done = 0;
+        emit finished(false);
+    }
+}
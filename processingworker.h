@@ -0,0 +1,118 @@
+#ifndef PROCESSINGWORKER_H
+#define PROCESSINGWORKER_H
+
+#include <QObject>
+#include <QImage>
+#include <QThreadPool>
+#include <QMutex>
+#include <QHash>
+#include <QQueue>
+
+#include <atomic>
+#include <memory>
+
+#include "projectsettings.h"
+#include "imagewriter.h"
+#include "diskcache.h"
+
+struct ProcessingJob {
+    quint64 fileId = 0;
+    QImage source;      // Null: decoded from sourcePath by the worker
+    QString sourcePath;
+    quint64 sourceKey = 0; // Content hash of source, 0: computed by the worker
+    QImage padded;         // Set: already padded, only exported
+    ProjectSettings settings;
+    QString exportPath; // Empty: process only, don't export
+    ExportStamp exportStamp;
+    bool progressive = false; // Report each finished band of a large sheet through bandProcessed()
+    int priorityY = 0;        // Bands closest to this target row are padded first
+    bool keepImage = true;    // Deliver the padded image, the CLI only needs the file written
+    bool decodeOnly = false;  // Only decode the source, never superseded by the file's other jobs
+};
+
+struct ProcessingResult {
+    quint64 fileId = 0;
+    QImage image;
+    QImage source; // Set when the worker decoded the source itself, for keepImage jobs
+    quint64 sourceKey = 0;
+    ProjectSettings settings;
+    QString error;
+    bool exported = false;
+    ImageWriter::Result exportResult = ImageWriter::Result::Failed;
+    ExportStamp exportStamp;
+    bool cached = false; // The export came from the disk cache
+    bool decodeOnly = false; // Only source is set, the job had decodeOnly
+    double decodeMs = 0; // Wall time of each stage, padding over all bands
+    double padMs = 0;
+    double encodeMs = 0;
+    double decodeCpuMs = 0; // CPU time of each stage, summed over the threads
+    double padCpuMs = 0;
+    double encodeCpuMs = 0;
+    QSize sourceSize;
+    QSize outputSize;       // Also set when image isn't kept
+    qint64 bytesRead = 0;   // Size of the source file, 0 if it was in memory
+    qint64 outputBytes = 0; // Size of the encoded export
+    qint64 bytesWritten = 0;
+};
+
+// Runs padding jobs on a thread pool as a pipeline of decode, pad and
+// encode/write stages, so different files overlap in different stages. Only a
+// bounded number of files are in flight at once, which caps memory use. Large
+// sheets are padded in row bands spread over the idle threads. Results are
+// delivered on the thread the worker lives in (the GUI thread) through queued
+// calls.
+class ProcessingWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProcessingWorker(QObject* parent = nullptr);
+    ~ProcessingWorker() override;
+
+    void submit(const ProcessingJob& job);
+    void cancel();
+    void supersede(quint64 fileId);
+    bool isBusy() const;
+    void setMaxThreadCount(int count);
+    void setDiskCache(DiskCache* cache); // Consulted for jobs that export, may be null
+    int maxThreadCount() const;
+
+    // Decoded sources, padded targets and encoded exports of the jobs in flight
+    qint64 memoryBytes() const;
+
+signals:
+    void fileProcessed(const ProcessingResult& result);
+    void bandProcessed(quint64 fileId, QSize targetSize, QPoint offset, const QImage& band);
+    void progressChanged(int done, int total);
+    void finished(bool cancelled);
+
+private:
+    struct JobState;
+    using JobStatePtr = std::shared_ptr<JobState>;
+
+    void feed();
+    void decode(const JobStatePtr& state);
+    void pad(const JobStatePtr& state);
+    void encode(const JobStatePtr& state);
+    void exportCached(const JobStatePtr& state, const QByteArray& sourceData, const QByteArray& data);
+    void deliverBand(const JobStatePtr& state, const QRect& rect);
+    void finish(const JobStatePtr& state);
+    void jobDone(const JobStatePtr& state);
+    bool isCancelled(const JobStatePtr& state) const;
+    bool isSuperseded(quint64 fileId, quint64 serial) const;
+
+    QThreadPool m_pool;
+    DiskCache* m_diskCache = nullptr;
+    // Shared with the job states, which can outlive the worker in the event queue
+    std::shared_ptr<std::atomic<qint64>> m_memoryBytes = std::make_shared<std::atomic<qint64>>(0);
+    mutable QMutex m_mutex;
+    QHash<quint64, quint64> m_latestSerial;
+    QHash<quint64, int> m_jobsPerFile; // Submitted and not done, m_latestSerial is kept while there are any
+    quint64 m_nextSerial = 1;
+    std::atomic<quint64> m_batch{1};
+    QQueue<JobStatePtr> m_queue;
+    int m_inFlight = 0;
+    int m_total = 0;
+    int m_done = 0;
+};
+
+#endif // PROCESSINGWORKER_H
@@ -15,18 +15,7 @@ bool Project::save(const QString& path) {
     QJsonObject root;
     root["version"] = 1;
 
-    QJsonObject settingsObj;
-    settingsObj["tileWidth"] = m_settings.tileWidth;
-    settingsObj["tileHeight"] = m_settings.tileHeight;
-    settingsObj["padding"] = m_settings.padding;
-    settingsObj["forcePot"] = m_settings.forcePot;
-    settingsObj["reorder"] = m_settings.reorder;
-    settingsObj["removePadding"] = m_settings.removePadding;
-    settingsObj["transparent"] = m_settings.transparent;
-    settingsObj["backgroundColor"] = m_settings.backgroundColor;
-    settingsObj["watchFile"] = m_settings.watchFile;
-    settingsObj["exportDirectory"] = m_settings.exportDirectory;
-    root["settings"] = settingsObj;
+    root["settings"] = settingsToJson(m_settings);
 
     QJsonArray filesArray;
     for (const auto& file : m_files) {
@@ -66,23 +55,14 @@ bool Project::load(const QString& path) {
 
     QJsonObject root = doc.object();
 
-    QJsonObject settingsObj = root["settings"].toObject();
-    m_settings.tileWidth = settingsObj["tileWidth"].toInt(16);
-    m_settings.tileHeight = settingsObj["tileHeight"].toInt(16);
-    m_settings.padding = settingsObj["padding"].toInt(1);
-    m_settings.forcePot = settingsObj["forcePot"].toBool(true);
-    m_settings.reorder = settingsObj["reorder"].toBool(false);
-    m_settings.removePadding = settingsObj["removePadding"].toBool(false);
-    m_settings.transparent = settingsObj["transparent"].toBool(true);
-    m_settings.backgroundColor = settingsObj["backgroundColor"].toString("#FF00FF");
-    m_settings.watchFile = settingsObj["watchFile"].toBool(false);
-    m_settings.exportDirectory = settingsObj["exportDirectory"].toString();
+    m_settings = settingsFromJson(root["settings"].toObject());
 
     m_files.clear();
     QJsonArray filesArray = root["files"].toArray();
     for (const auto& val : filesArray) {
         QJsonObject fileObj = val.toObject();
         FileEntry entry;
+        entry.id = nextFileId();
         entry.sourcePath = fileObj["sourcePath"].toString();
         entry.exportPath = fileObj["exportPath"].toString();
         m_files.append(entry);
@@ -96,6 +76,7 @@ bool Project::load(const QString& path) {
 
 int Project::addFile(const QString& sourcePath) {
     FileEntry entry;
+    entry.id = nextFileId();
     entry.sourcePath = sourcePath;
     if (!m_settings.exportDirectory.isEmpty()) {
         QFileInfo info(sourcePath);
@@ -127,6 +108,21 @@ const FileEntry& Project::fileAt(int index) const {
     return m_files[index];
 }
 
+int Project::indexOfFile(quint64 id) const {
+    for (int i = 0; i < m_files.size(); i++) {
+        if (m_files[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+quint64 Project::nextFileId() {
+    // Shared by all projects, so results of a closed project never match a new one
+    static quint64 nextId = 1;
+    return nextId++;
+}
+
 QString Project::projectPath() const {
     return m_projectPath;
 }
@@ -166,6 +162,36 @@ void Project::clear() {
     m_modified = false;
 }
 
+QJsonObject Project::settingsToJson(const ProjectSettings& settings) {
+    QJsonObject settingsObj;
+    settingsObj["tileWidth"] = settings.tileWidth;
+    settingsObj["tileHeight"] = settings.tileHeight;
+    settingsObj["padding"] = settings.padding;
+    settingsObj["forcePot"] = settings.forcePot;
+    settingsObj["reorder"] = settings.reorder;
+    settingsObj["removePadding"] = settings.removePadding;
+    settingsObj["transparent"] = settings.transparent;
+    settingsObj["backgroundColor"] = settings.backgroundColor;
+    settingsObj["watchFile"] = settings.watchFile;
+    settingsObj["exportDirectory"] = settings.exportDirectory;
+    return settingsObj;
+}
+
+ProjectSettings Project::settingsFromJson(const QJsonObject& settingsObj, const ProjectSettings& defaults) {
+    ProjectSettings settings;
+    settings.tileWidth = settingsObj["tileWidth"].toInt(defaults.tileWidth);
+    settings.tileHeight = settingsObj["tileHeight"].toInt(defaults.tileHeight);
+    settings.padding = settingsObj["padding"].toInt(defaults.padding);
+    settings.forcePot = settingsObj["forcePot"].toBool(defaults.forcePot);
+    settings.reorder = settingsObj["reorder"].toBool(defaults.reorder);
+    settings.removePadding = settingsObj["removePadding"].toBool(defaults.removePadding);
+    settings.transparent = settingsObj["transparent"].toBool(defaults.transparent);
+    settings.backgroundColor = settingsObj["backgroundColor"].toString(defaults.backgroundColor);
+    settings.watchFile = settingsObj["watchFile"].toBool(defaults.watchFile);
+    settings.exportDirectory = settingsObj["exportDirectory"].toString(defaults.exportDirectory);
+    return settings;
+}
+
 QString Project::defaultExportPath(const QString& sourcePath) {
     QFileInfo info(sourcePath);
     return info.absoluteDir().path() + "/" + info.completeBaseName() + ".export." + info.suffix();
@@ -5,25 +5,21 @@
 #include <QList>
 #include <QPixmap>
 #include <QColor>
+#include <QJsonObject>
 
-struct ProjectSettings {
-    int tileWidth = 16;
-    int tileHeight = 16;
-    int padding = 1;
-    bool forcePot = true;
-    bool reorder = false;
-    bool removePadding = false;
-    bool transparent = true;
-    QString backgroundColor = "#FF00FF";
-    bool watchFile = false;
-    QString exportDirectory;
-};
+#include "imagewriter.h"
+#include "projectsettings.h"
 
 struct FileEntry {
+    quint64 id = 0; // Stable across index changes, identifies the file in background jobs
     QString sourcePath;
     QString exportPath;
+    QSize sourceSize; // Known from the image header before the source is decoded
     QPixmap sourcePixmap;
     QPixmap resultPixmap;
+    ProjectSettings processedSettings; // Settings resultPixmap was made with, to recompute it after eviction
+    quint64 sourceKey = 0; // Content hash of the decoded source, 0 until the worker computed it
+    ExportStamp exportStamp;
     bool dirty = false;
     bool processed = false;
 };
@@ -41,6 +37,7 @@ public:
     int fileCount() const;
     FileEntry& fileAt(int index);
     const FileEntry& fileAt(int index) const;
+    int indexOfFile(quint64 id) const;
 
     QString projectPath() const;
     void setProjectPath(const QString& path);
@@ -56,11 +53,17 @@ public:
 
     static QString defaultExportPath(const QString& sourcePath);
 
+    // The "settings" object of the project file, missing fields are taken from defaults
+    static QJsonObject settingsToJson(const ProjectSettings& settings);
+    static ProjectSettings settingsFromJson(const QJsonObject& settingsObj, const ProjectSettings& defaults = ProjectSettings());
+
     // Recent projects (stored in QSettings)
     static QStringList recentProjects();
     static void addRecentProject(const QString& path);
 
 private:
+    static quint64 nextFileId();
+
     QString m_projectPath;
     ProjectSettings m_settings;
     QList<FileEntry> m_files;
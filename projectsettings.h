@@ -0,0 +1,19 @@
+#ifndef PROJECTSETTINGS_H
+#define PROJECTSETTINGS_H
+
+#include <QString>
+
+struct ProjectSettings {
+    int tileWidth = 16;
+    int tileHeight = 16;
+    int padding = 1;
+    bool forcePot = true;
+    bool reorder = false;
+    bool removePadding = false;
+    bool transparent = true;
+    QString backgroundColor = "#FF00FF";
+    bool watchFile = false;
+    QString exportDirectory;
+};
+
+#endif // PROJECTSETTINGS_H
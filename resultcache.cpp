@@ -0,0 +1,77 @@
+#include "resultcache.h"
+#include "tileprocessor.h"
+
+#include <iterator>
+
+ResultCache::ResultCache() {
+    setBudget(DefaultBudgetMB * 1024 * 1024);
+}
+
+void ResultCache::setBudget(qint64 bytes) {
+    m_results.setMaxCost(bytes / 1024);
+}
+
+qint64 ResultCache::budget() const {
+    return qint64(m_results.maxCost()) * 1024;
+}
+
+qint64 ResultCache::totalBytes() const {
+    return qint64(m_results.totalCost()) * 1024;
+}
+
+qint64 ResultCache::totalBytes(const QSet<qint64>& sharedPixmaps) const {
+    qint64 total = 0;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (m_results.contains(it.key()) && !sharedPixmaps.contains(it->pixmapKey)) {
+            total += it->bytes;
+        }
+    }
+    return total;
+}
+
+QPixmap ResultCache::find(quint64 fileId, quint64 sourceKey, const ProjectSettings& settings) {
+    if (sourceKey == 0) {
+        return QPixmap();
+    }
+    QPixmap* result = m_results.object(key(fileId, sourceKey, settings));
+    return result ? *result : QPixmap();
+}
+
+void ResultCache::insert(quint64 fileId, quint64 sourceKey, const ProjectSettings& settings, const QPixmap& result) {
+    if (sourceKey == 0 || result.isNull()) {
+        return;
+    }
+    // The pixmap shares its data with the FileEntry while it is the current result
+    qint64 bytes = qint64(result.width()) * result.height() * result.depth() / 8;
+    QByteArray resultKey = key(fileId, sourceKey, settings);
+    m_results.insert(resultKey, new QPixmap(result), qMax<qint64>(1, bytes / 1024));
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        it = m_results.contains(it.key()) ? std::next(it) : m_entries.erase(it);
+    }
+    if (m_results.contains(resultKey)) {
+        m_entries.insert(resultKey, { result.cacheKey(), bytes });
+    }
+}
+
+void ResultCache::removeFile(quint64 fileId) {
+    QByteArray prefix(reinterpret_cast<const char*>(&fileId), sizeof(fileId));
+    for (const QByteArray& k : m_results.keys()) {
+        if (k.startsWith(prefix)) {
+            m_results.remove(k);
+            m_entries.remove(k);
+        }
+    }
+}
+
+void ResultCache::clear() {
+    m_results.clear();
+    m_entries.clear();
+}
+
+QByteArray ResultCache::key(quint64 fileId, quint64 sourceKey, const ProjectSettings& settings) {
+    QByteArray result;
+    result.append(reinterpret_cast<const char*>(&fileId), sizeof(fileId));
+    result.append(reinterpret_cast<const char*>(&sourceKey), sizeof(sourceKey));
+    result.append(TileProcessor::settingsKey(settings));
+    return result;
+}
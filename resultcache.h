@@ -0,0 +1,49 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QByteArray>
+#include <QPixmap>
+
+#include "project.h"
+
+// Padded results per file, keyed by the source content and the settings that
+// affect the result. Switching back to a combination that was already
+// computed takes the result from here instead of padding again.
+class ResultCache
+{
+public:
+    static constexpr qint64 DefaultBudgetMB = 256;
+
+    ResultCache();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 totalBytes() const;
+
+    // The same without the pixmaps of the set (QPixmap::cacheKey()), which are
+    // also still held elsewhere, like the current result of a file
+    qint64 totalBytes(const QSet<qint64>& sharedPixmaps) const;
+
+    QPixmap find(quint64 fileId, quint64 sourceKey, const ProjectSettings& settings);
+    void insert(quint64 fileId, quint64 sourceKey, const ProjectSettings& settings, const QPixmap& result);
+    void removeFile(quint64 fileId);
+    void clear();
+
+private:
+    static QByteArray key(quint64 fileId, quint64 sourceKey, const ProjectSettings& settings);
+
+    struct Entry {
+        qint64 pixmapKey;
+        qint64 bytes;
+    };
+
+    QCache<QByteArray, QPixmap> m_results; // Cost in KB
+    // What totalBytes() needs of every result, without touching the LRU order
+    // of m_results. Entries QCache evicted are dropped on the next insert.
+    QHash<QByteArray, Entry> m_entries;
+};
+
+#endif // RESULTCACHE_H
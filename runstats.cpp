@@ -0,0 +1,198 @@
+#include "runstats.h"
+#include "tileprocessor.h"
+
+#include <QBuffer>
+#include <QImageReader>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+// Exports are uploaded as uncompressed RGBA8 textures
+static const int TextureBytesPerPixel = 4;
+
+static QJsonObject sizeToJson(const QSize& size) {
+    QJsonObject object;
+    object["width"] = size.width();
+    object["height"] = size.height();
+    return object;
+}
+
+RunStats::RunStats() {
+    m_clock.start();
+    m_startCpuNs = processCpuNs();
+}
+
+void RunStats::addResult(const QString& input, const QString& output, const ProcessingResult& result,
+                         const ProjectSettings& settings) {
+    QString status = "saved";
+    QString error = result.error;
+    if (error.isEmpty() && result.exportResult == ImageWriter::Result::Failed) {
+        error = "Could not save image: " + output;
+    }
+    if (!error.isEmpty()) {
+        status = "error";
+    } else if (result.exportResult == ImageWriter::Result::Skipped) {
+        status = "unchanged";
+    }
+
+    int tiles = TileProcessor::tileCount(result.sourceSize, settings);
+    qint64 textureBytes = qint64(result.outputSize.width()) * result.outputSize.height() * TextureBytesPerPixel;
+    Stages wall{ result.decodeMs, result.padMs, result.encodeMs };
+    Stages cpu{ result.decodeCpuMs, result.padCpuMs, result.encodeCpuMs };
+
+    QJsonObject file;
+    file["input"] = input;
+    file["output"] = output;
+    file["status"] = status;
+    if (!error.isEmpty()) {
+        file["error"] = error;
+    }
+    file["cached"] = result.cached;
+    file["source"] = sizeToJson(result.sourceSize);
+    file["result"] = sizeToJson(result.outputSize);
+    file["tiles"] = tiles;
+    file["bytesRead"] = result.bytesRead;
+    file["outputBytes"] = result.outputBytes;
+    file["bytesWritten"] = result.bytesWritten;
+    file["textureBytes"] = textureBytes;
+    file["wallMs"] = stagesToJson(wall);
+    file["cpuMs"] = stagesToJson(cpu);
+    m_files.append(file);
+
+    count(status);
+    m_cached += result.cached ? 1 : 0;
+    m_tiles += tiles;
+    m_bytesRead += result.bytesRead;
+    m_bytesWritten += result.bytesWritten;
+    m_textureBytes += textureBytes;
+    m_wallMs.decode += wall.decode;
+    m_wallMs.pad += wall.pad;
+    m_wallMs.encode += wall.encode;
+    m_cpuMs.decode += cpu.decode;
+    m_cpuMs.pad += cpu.pad;
+    m_cpuMs.encode += cpu.encode;
+}
+
+void RunStats::addStatus(const QString& input, const QString& output, const QString& status, const QString& error) {
+    QJsonObject file;
+    file["input"] = input;
+    file["output"] = output;
+    file["status"] = status;
+    if (!error.isEmpty()) {
+        file["error"] = error;
+    }
+    m_files.append(file);
+    count(status);
+}
+
+void RunStats::count(const QString& status) {
+    m_counts[status] = m_counts.value(status).toInt() + 1;
+}
+
+QJsonObject RunStats::stagesToJson(const Stages& stages) {
+    QJsonObject object;
+    object["decode"] = stages.decode;
+    object["pad"] = stages.pad;
+    object["encode"] = stages.encode;
+    return object;
+}
+
+QJsonObject RunStats::toJson() const {
+    // Stage times are summed over files, which run in parallel, so they can
+    // add up to more than the wall time of the run
+    QJsonObject totals;
+    totals["files"] = m_files.size();
+    totals["status"] = m_counts;
+    totals["cached"] = m_cached;
+    totals["tiles"] = m_tiles;
+    totals["bytesRead"] = m_bytesRead;
+    totals["bytesWritten"] = m_bytesWritten;
+    totals["textureBytes"] = m_textureBytes;
+    totals["wallMs"] = stagesToJson(m_wallMs);
+    totals["cpuMs"] = stagesToJson(m_cpuMs);
+
+    QJsonObject run;
+    run["wallMs"] = m_clock.nsecsElapsed() / 1000000.0;
+    run["cpuMs"] = (processCpuNs() - m_startCpuNs) / 1000000.0;
+    run["peakResidentBytes"] = peakResidentBytes();
+
+    QJsonObject report;
+    report["files"] = m_files;
+    report["totals"] = totals;
+    report["run"] = run;
+    return report;
+}
+
+QSize RunStats::encodedSize(const QByteArray& data) {
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    return QImageReader(&buffer).size();
+}
+
+#ifdef Q_OS_WIN
+static qint64 fileTimeNs(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return qint64(value.QuadPart) * 100;
+}
+#endif
+
+qint64 RunStats::threadCpuNs() {
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    return fileTimeNs(kernel) + fileTimeNs(user);
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+qint64 RunStats::processCpuNs() {
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    return fileTimeNs(kernel) + fileTimeNs(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000
+        + (qint64(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+#endif
+}
+
+qint64 RunStats::peakResidentBytes() {
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return qint64(counters.PeakWorkingSetSize);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef Q_OS_MACOS
+    return qint64(usage.ru_maxrss); // Bytes on macOS
+#else
+    return qint64(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
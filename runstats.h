@@ -0,0 +1,60 @@
+#ifndef RUNSTATS_H
+#define RUNSTATS_H
+
+#include <QString>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+#include "processingworker.h"
+
+// Collects the statistics of a CLI run for --stats: one record per file and
+// totals over the run, as a JSON report for build dashboards.
+class RunStats
+{
+public:
+    RunStats();
+
+    void addResult(const QString& input, const QString& output, const ProcessingResult& result,
+                   const ProjectSettings& settings);
+
+    // A file that wasn't processed: failed before the worker saw it, or up to date
+    void addStatus(const QString& input, const QString& output, const QString& status,
+                   const QString& error = QString());
+
+    QJsonObject toJson() const;
+
+    // CPU time of the calling thread, and of the whole process, in nanoseconds
+    static qint64 threadCpuNs();
+    static qint64 processCpuNs();
+
+    // Largest resident set of the process so far, 0 where unknown
+    static qint64 peakResidentBytes();
+
+    // Dimensions of encoded image data, read from its header only
+    static QSize encodedSize(const QByteArray& data);
+
+private:
+    struct Stages {
+        double decode = 0;
+        double pad = 0;
+        double encode = 0;
+    };
+
+    static QJsonObject stagesToJson(const Stages& stages);
+    void count(const QString& status);
+
+    QJsonArray m_files;
+    QJsonObject m_counts;
+    QElapsedTimer m_clock;
+    qint64 m_startCpuNs;
+    qint64 m_tiles = 0;
+    qint64 m_bytesRead = 0;
+    qint64 m_bytesWritten = 0;
+    qint64 m_textureBytes = 0;
+    int m_cached = 0;
+    Stages m_wallMs;
+    Stages m_cpuMs;
+};
+
+#endif // RUNSTATS_H
@@ -327,6 +327,20 @@ QString ThemeManager::buildStyleSheet(bool dark) const {
         "  background-color: %6;"
         "}"
 
+        /* ---- QProgressBar ---- */
+        "QProgressBar {"
+        "  background-color: %6;"
+        "  border: 1px solid %4;"
+        "  border-radius: 4px;"
+        "  color: %2;"
+        "  text-align: center;"
+        "  min-height: 20px;"
+        "}"
+        "QProgressBar::chunk {"
+        "  background-color: %8;"
+        "  border-radius: 3px;"
+        "}"
+
         /* ---- QLabel ---- */
         "QLabel {"
         "  background: transparent;"
@@ -0,0 +1,346 @@
+#include "tilepad.h"
+#include "paddingengine.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+
+// Smaller images are padded in one piece, same as in ProcessingWorker
+static const qint64 BandPixelThreshold = 2048 * 2048;
+
+// Lowered by tilepad_set_band_threshold(), so tests reach the band path with small images
+static std::atomic<qint64> s_bandThreshold { BandPixelThreshold };
+
+struct tilepad_job {
+    PaddingOptions options;
+    bool removePadding = false;
+    PixelView source;
+    PixelView target;
+    bool hasSource = false;
+    bool hasTarget = false;
+
+    // Guards running and status, the rest isn't touched while running
+    mutable QMutex mutex;
+    QWaitCondition finished;
+    bool running = false;
+    int status = TILEPAD_OK;
+    std::atomic<int> bandsLeft { 0 };
+    std::atomic<bool> failed { false };
+};
+
+// Separate from the global pool, so a Qt application embedding the library
+// keeps its own threads
+static QThreadPool& pool() {
+    static QThreadPool s_pool;
+    return s_pool;
+}
+
+static bool pixelFormat(int format, PixelFormat* result) {
+    switch (format) {
+    case TILEPAD_FORMAT_ARGB32:
+        *result = PixelFormat::Argb32;
+        return true;
+    case TILEPAD_FORMAT_ARGB32_PREMULTIPLIED:
+        *result = PixelFormat::Argb32Premultiplied;
+        return true;
+    case TILEPAD_FORMAT_RGBA8888:
+        *result = PixelFormat::Rgba8888;
+        return true;
+    case TILEPAD_FORMAT_RGBA8888_PREMULTIPLIED:
+        *result = PixelFormat::Rgba8888Premultiplied;
+        return true;
+    }
+    return false;
+}
+
+static int setView(PixelView& view, void* data, int width, int height, ptrdiff_t stride, int format) {
+    PixelView result;
+    if (!pixelFormat(format, &result.format) || width < 0 || height < 0 || stride < ptrdiff_t(width) * 4
+        || (data == nullptr && width > 0 && height > 0)) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    result.data = static_cast<uint8_t*>(data);
+    result.width = width;
+    result.height = height;
+    result.stride = stride;
+    view = result;
+    return TILEPAD_OK;
+}
+
+static tilepad_layout layoutOf(const tilepad_job* job) {
+    tilepad_layout result = {};
+    const PaddingOptions& options = job->options;
+    result.grid_width = options.tileWidth + options.padding * 2;
+    result.grid_height = options.tileHeight + options.padding * 2;
+    if (job->removePadding) {
+        result.cols = job->source.width / result.grid_width;
+        result.rows = job->source.height / result.grid_height;
+        PaddingEngine::removedSize(job->source.width, job->source.height, options, &result.width, &result.height);
+        result.tiles_per_row = result.cols;
+        result.band_rows = result.rows;
+        return result;
+    }
+    PaddingLayout layout = PaddingEngine::layout(job->source.width, job->source.height, options);
+    result.cols = layout.cols;
+    result.rows = layout.rows;
+    result.width = layout.width;
+    result.height = layout.height;
+    result.tiles_per_row = layout.tilesPerRow;
+    result.band_rows = layout.bandRows;
+    return result;
+}
+
+static int checkReady(const tilepad_job* job) {
+    if (!job->hasSource) {
+        return TILEPAD_NO_SOURCE;
+    }
+    if (!job->hasTarget) {
+        return TILEPAD_NO_TARGET;
+    }
+    tilepad_layout layout = layoutOf(job);
+    if (job->target.width != layout.width || job->target.height != layout.height) {
+        return TILEPAD_SIZE_MISMATCH;
+    }
+    return TILEPAD_OK;
+}
+
+static bool execute(const tilepad_job* job) {
+    if (job->removePadding) {
+        return PaddingEngine::removePadding(job->source, job->target, job->options);
+    }
+    return PaddingEngine::pad(job->source, job->target, job->options);
+}
+
+static void finish(tilepad_job* job) {
+    QMutexLocker locker(&job->mutex);
+    job->status = job->failed ? TILEPAD_FAILED : TILEPAD_OK;
+    job->running = false;
+    job->finished.wakeAll();
+}
+
+// Large images are split into bands of grid rows that render concurrently
+static void executeOnPool(tilepad_job* job) {
+    qint64 pixels = qint64(job->target.width) * job->target.height;
+    int bandRows = layoutOf(job).band_rows;
+    if (job->removePadding || pixels < s_bandThreshold || bandRows < 2) {
+        job->failed = !execute(job);
+        finish(job);
+        return;
+    }
+    if (!PaddingEngine::clear(job->target, job->options)) {
+        job->failed = true;
+        finish(job);
+        return;
+    }
+    int bands = qBound(1, bandRows, pool().maxThreadCount() * 2);
+    job->bandsLeft = bands;
+    for (int b = 0; b < bands; b++) {
+        int firstRow = bandRows * b / bands;
+        int lastRow = bandRows * (b + 1) / bands;
+        pool().start([job, firstRow, lastRow]() {
+            if (!PaddingEngine::renderBand(job->source, job->target, job->options, firstRow, lastRow)) {
+                job->failed = true;
+            }
+            if (--job->bandsLeft == 0) {
+                finish(job);
+            }
+        });
+    }
+}
+
+int tilepad_abi_version(void) {
+    return TILEPAD_ABI_VERSION;
+}
+
+const char* tilepad_status_text(int status) {
+    switch (status) {
+    case TILEPAD_OK:
+        return "ok";
+    case TILEPAD_INVALID_ARGUMENT:
+        return "invalid argument";
+    case TILEPAD_SIZE_MISMATCH:
+        return "target size doesn't match the layout";
+    case TILEPAD_NO_SOURCE:
+        return "no source set";
+    case TILEPAD_NO_TARGET:
+        return "no target set";
+    case TILEPAD_BUSY:
+        return "job is running";
+    case TILEPAD_FAILED:
+        return "failed";
+    }
+    return "unknown status";
+}
+
+void tilepad_default_options(tilepad_options* options) {
+    if (options == nullptr) {
+        return;
+    }
+    PaddingOptions defaults;
+    options->tile_width = defaults.tileWidth;
+    options->tile_height = defaults.tileHeight;
+    options->padding = defaults.padding;
+    options->force_pot = defaults.forcePot;
+    options->reorder = defaults.reorder;
+    options->transparent = defaults.transparent;
+    options->background_color = defaults.backgroundColor;
+    options->remove_padding = 0;
+}
+
+void tilepad_set_thread_count(int count) {
+    pool().setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
+
+void tilepad_set_band_threshold(int64_t pixels) {
+    s_bandThreshold = pixels > 0 ? qint64(pixels) : BandPixelThreshold;
+}
+
+tilepad_job* tilepad_job_create(const tilepad_options* options) {
+    if (options == nullptr) {
+        return nullptr;
+    }
+    PaddingOptions padding;
+    padding.tileWidth = options->tile_width;
+    padding.tileHeight = options->tile_height;
+    padding.padding = options->padding;
+    padding.forcePot = options->force_pot != 0;
+    padding.reorder = options->reorder != 0;
+    padding.transparent = options->transparent != 0;
+    padding.backgroundColor = options->background_color;
+    if (!PaddingEngine::isValid(padding)) {
+        return nullptr;
+    }
+    tilepad_job* job = new tilepad_job;
+    job->options = padding;
+    job->removePadding = options->remove_padding != 0;
+    return job;
+}
+
+void tilepad_job_destroy(tilepad_job* job) {
+    if (job == nullptr) {
+        return;
+    }
+    tilepad_job_wait(job);
+    delete job;
+}
+
+int tilepad_job_set_source(tilepad_job* job, const void* data, int width, int height, ptrdiff_t stride, int format) {
+    if (job == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    QMutexLocker locker(&job->mutex);
+    if (job->running) {
+        return TILEPAD_BUSY;
+    }
+    // The padded target of a larger source would overflow the int sizes
+    if (!job->removePadding && !PaddingEngine::fits(width, height, job->options)) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    // Only ever read, the view type is shared with the target
+    int status = setView(job->source, const_cast<void*>(data), width, height, stride, format);
+    job->hasSource = job->hasSource || status == TILEPAD_OK;
+    return status;
+}
+
+int tilepad_job_set_target(tilepad_job* job, void* data, int width, int height, ptrdiff_t stride, int format) {
+    if (job == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    QMutexLocker locker(&job->mutex);
+    if (job->running) {
+        return TILEPAD_BUSY;
+    }
+    int status = setView(job->target, data, width, height, stride, format);
+    job->hasTarget = job->hasTarget || status == TILEPAD_OK;
+    return status;
+}
+
+int tilepad_job_layout(const tilepad_job* job, tilepad_layout* layout) {
+    if (job == nullptr || layout == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    if (!job->hasSource) {
+        return TILEPAD_NO_SOURCE;
+    }
+    *layout = layoutOf(job);
+    return TILEPAD_OK;
+}
+
+int tilepad_job_tile_position(const tilepad_job* job, int index, int* x, int* y) {
+    if (job == nullptr || x == nullptr || y == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    if (!job->hasSource) {
+        return TILEPAD_NO_SOURCE;
+    }
+    tilepad_layout layout = layoutOf(job);
+    if (index < 0 || index >= qint64(layout.cols) * layout.rows || layout.tiles_per_row <= 0) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    if (job->removePadding) {
+        *x = index % layout.cols * job->options.tileWidth;
+        *y = index / layout.cols * job->options.tileHeight;
+    } else {
+        *x = index % layout.tiles_per_row * layout.grid_width + job->options.padding;
+        *y = index / layout.tiles_per_row * layout.grid_height + job->options.padding;
+    }
+    return TILEPAD_OK;
+}
+
+int tilepad_job_run(tilepad_job* job) {
+    if (job == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    QMutexLocker locker(&job->mutex);
+    if (job->running) {
+        return TILEPAD_BUSY;
+    }
+    int status = checkReady(job);
+    if (status == TILEPAD_OK && !execute(job)) {
+        status = TILEPAD_FAILED;
+    }
+    job->status = status;
+    return status;
+}
+
+int tilepad_job_start(tilepad_job* job) {
+    if (job == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    QMutexLocker locker(&job->mutex);
+    if (job->running) {
+        return TILEPAD_BUSY;
+    }
+    int status = checkReady(job);
+    job->status = status;
+    if (status != TILEPAD_OK) {
+        return status;
+    }
+    job->running = true;
+    job->failed = false;
+    pool().start([job]() { executeOnPool(job); });
+    return TILEPAD_OK;
+}
+
+int tilepad_job_wait(tilepad_job* job) {
+    if (job == nullptr) {
+        return TILEPAD_INVALID_ARGUMENT;
+    }
+    QMutexLocker locker(&job->mutex);
+    while (job->running) {
+        job->finished.wait(&job->mutex);
+    }
+    return job->status;
+}
+
+int tilepad_job_is_finished(const tilepad_job* job) {
+    if (job == nullptr) {
+        return 0;
+    }
+    QMutexLocker locker(&job->mutex);
+    return job->running ? 0 : 1;
+}
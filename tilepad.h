@@ -0,0 +1,131 @@
+#ifndef TILEPAD_H
+#define TILEPAD_H
+
+/*
+ * C interface of the TilePad padding engine (libtilepad), for tools written
+ * in other languages. Pixel buffers stay owned by the caller and are used in
+ * place, nothing is copied. A job pads (or removes the padding of) one image,
+ * either synchronously or on the library's thread pool, where large images are
+ * split into bands rendered in parallel. The results equal the ones of the
+ * TilePad application.
+ *
+ * Functions return TILEPAD_OK or an error status. A job must not be used from
+ * several threads at the same time, different jobs can.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(TILEPAD_BUILD)
+#    define TILEPAD_API __declspec(dllexport)
+#  else
+#    define TILEPAD_API __declspec(dllimport)
+#  endif
+#else
+#  define TILEPAD_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Changes whenever a struct or a signature changes */
+#define TILEPAD_ABI_VERSION 1
+
+/* 32-bit pixel layouts. ARGB32 is 0xAARRGGBB in a native 32-bit word (B, G, R,
+ * A in memory on little endian), RGBA8888 is R, G, B, A in memory. */
+enum {
+    TILEPAD_FORMAT_ARGB32 = 0,
+    TILEPAD_FORMAT_ARGB32_PREMULTIPLIED = 1,
+    TILEPAD_FORMAT_RGBA8888 = 2,
+    TILEPAD_FORMAT_RGBA8888_PREMULTIPLIED = 3
+};
+
+enum {
+    TILEPAD_OK = 0,
+    TILEPAD_INVALID_ARGUMENT = 1, /* Bad options, buffer or format */
+    TILEPAD_SIZE_MISMATCH = 2,    /* The target doesn't have the size of the layout */
+    TILEPAD_NO_SOURCE = 3,
+    TILEPAD_NO_TARGET = 4,
+    TILEPAD_BUSY = 5,             /* The job is running on the thread pool */
+    TILEPAD_FAILED = 6
+};
+
+typedef struct tilepad_options {
+    int tile_width;
+    int tile_height;
+    int padding;
+    int force_pot;              /* Power of two target size */
+    int reorder;                /* Fill the rows of a force_pot target */
+    int transparent;            /* Otherwise the padding around tiles is background_color */
+    uint32_t background_color;  /* 0xAARRGGBB */
+    int remove_padding;         /* Cut the tiles out of a padded source instead */
+} tilepad_options;
+
+/* Tile i of the source (row by row) goes to grid cell (i % tiles_per_row,
+ * i / tiles_per_row) of the target, padding pixels from the cell's corner. When
+ * removing padding, the grid cells are in the source and the tiles are packed
+ * in the target. */
+typedef struct tilepad_layout {
+    int cols;           /* Whole tiles in a row */
+    int rows;           /* Whole tiles in a column */
+    int grid_width;     /* A tile with its padding on both sides */
+    int grid_height;
+    int width;          /* Of the target */
+    int height;
+    int tiles_per_row;
+    int band_rows;      /* Grid rows of the target the work is split at */
+} tilepad_layout;
+
+typedef struct tilepad_job tilepad_job;
+
+TILEPAD_API int tilepad_abi_version(void);
+TILEPAD_API const char* tilepad_status_text(int status);
+
+/* 16x16 tiles, 1 pixel padding, force_pot and transparent, like the application */
+TILEPAD_API void tilepad_default_options(tilepad_options* options);
+
+/* Threads of the pool used by tilepad_job_start(), 0 for one per core */
+TILEPAD_API void tilepad_set_thread_count(int count);
+
+/* Targets of at least this many pixels are split into bands by
+ * tilepad_job_start(), 0 for the default of 2048 x 2048. A low value lets tests
+ * cover the band path with small images. */
+TILEPAD_API void tilepad_set_band_threshold(int64_t pixels);
+
+/* NULL if the options are invalid: tile sizes must be from 1 to 65536 and the
+ * padding from 0 to 65536 */
+TILEPAD_API tilepad_job* tilepad_job_create(const tilepad_options* options);
+
+/* Waits for a running job first */
+TILEPAD_API void tilepad_job_destroy(tilepad_job* job);
+
+/* The buffers must stay valid until the job has finished. stride is the
+ * number of bytes from one row to the next. A source is rejected if a side of
+ * its padded target would exceed 2^28 pixels. */
+TILEPAD_API int tilepad_job_set_source(tilepad_job* job, const void* data, int width, int height,
+                                       ptrdiff_t stride, int format);
+TILEPAD_API int tilepad_job_set_target(tilepad_job* job, void* data, int width, int height,
+                                       ptrdiff_t stride, int format);
+
+/* Available once the source is set, tells the size the target must have */
+TILEPAD_API int tilepad_job_layout(const tilepad_job* job, tilepad_layout* layout);
+
+/* Position in the target of the top left pixel of tile index */
+TILEPAD_API int tilepad_job_tile_position(const tilepad_job* job, int index, int* x, int* y);
+
+/* Runs the job on the calling thread */
+TILEPAD_API int tilepad_job_run(tilepad_job* job);
+
+/* Runs the job on the thread pool and returns at once. tilepad_job_wait()
+ * blocks until it has finished and returns its status. */
+TILEPAD_API int tilepad_job_start(tilepad_job* job);
+TILEPAD_API int tilepad_job_wait(tilepad_job* job);
+TILEPAD_API int tilepad_job_is_finished(const tilepad_job* job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TILEPAD_H */
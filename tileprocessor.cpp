@@ -0,0 +1,79 @@
+#include "tileprocessor.h"
+#include "paddingremover.h"
+
+#include <QDataStream>
+#include <QColor>
+#include <QHash>
+
+QImage TileProcessor::process(const QImage& source, const ProjectSettings& settings) {
+    QImage sourceImage = source;
+    if (settings.removePadding) {
+        PaddingRemover remover;
+        remover.setTileSize(settings.tileWidth, settings.tileHeight);
+        remover.setPadding(settings.padding);
+        return *remover.create(&sourceImage);
+    }
+    PaddingGenerator generator;
+    configure(generator, settings);
+    QImage* target = generator.prepare(&sourceImage);
+    generator.renderBand(sourceImage, 0, generator.bandRowCount());
+    return *target;
+}
+
+void TileProcessor::configure(PaddingGenerator& generator, const ProjectSettings& settings) {
+    generator.setTileSize(settings.tileWidth, settings.tileHeight);
+    generator.setPadding(settings.padding);
+    generator.setForcePot(settings.forcePot);
+    generator.setReorder(settings.reorder);
+    generator.setTransparent(settings.transparent);
+    generator.setBackgroundColor(QColor::fromString(settings.backgroundColor));
+}
+
+bool TileProcessor::isValid(const ProjectSettings& settings) {
+    return PaddingEngine::isValid(options(settings));
+}
+
+PaddingOptions TileProcessor::options(const ProjectSettings& settings) {
+    PaddingOptions options;
+    options.tileWidth = settings.tileWidth;
+    options.tileHeight = settings.tileHeight;
+    options.padding = settings.padding;
+    options.forcePot = settings.forcePot;
+    options.reorder = settings.reorder;
+    options.transparent = settings.transparent;
+    options.backgroundColor = QColor::fromString(settings.backgroundColor).rgba();
+    return options;
+}
+
+int TileProcessor::tileCount(const QSize& sourceSize, const ProjectSettings& settings) {
+    // A padded source has a grid cell around every tile
+    int border = settings.removePadding ? settings.padding * 2 : 0;
+    int cellWidth = settings.tileWidth + border;
+    int cellHeight = settings.tileHeight + border;
+    if (cellWidth <= 0 || cellHeight <= 0) {
+        return 0;
+    }
+    return (sourceSize.width() / cellWidth) * (sourceSize.height() / cellHeight);
+}
+
+quint64 TileProcessor::sourceKey(const QImage& image) {
+    if (image.isNull()) {
+        return 0;
+    }
+    size_t seed = qHashMulti(0, image.width(), image.height(), int(image.format()));
+    quint64 result = qHashBits(image.constBits(), size_t(image.sizeInBytes()), seed);
+    return result ? result : 1;
+}
+
+QByteArray TileProcessor::settingsKey(const ProjectSettings& settings) {
+    QByteArray result;
+    QDataStream out(&result, QIODevice::WriteOnly);
+    out << settings.tileWidth << settings.tileHeight << settings.padding << settings.removePadding;
+    if (!settings.removePadding) {
+        out << settings.forcePot << settings.reorder << settings.transparent;
+        if (!settings.transparent) {
+            out << QColor::fromString(settings.backgroundColor).rgba();
+        }
+    }
+    return result;
+}
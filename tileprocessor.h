@@ -0,0 +1,40 @@
+#ifndef TILEPROCESSOR_H
+#define TILEPROCESSOR_H
+
+#include <QImage>
+#include <QByteArray>
+
+#include "projectsettings.h"
+#include "paddinggenerator.h"
+#include "paddingengine.h"
+
+// Applies (or removes) padding according to the given settings. Uses its own
+// generator/remover instances, so it is safe to call from worker threads.
+// Only needs QtCore and QImage, no GUI application.
+class TileProcessor
+{
+public:
+    static QImage process(const QImage& source, const ProjectSettings& settings);
+    static void configure(PaddingGenerator& generator, const ProjectSettings& settings);
+
+    // False for tile sizes below 1 or a negative padding, which can't be processed
+    static bool isValid(const ProjectSettings& settings);
+
+    // The settings as options of the raw buffer API
+    static PaddingOptions options(const ProjectSettings& settings);
+
+    // Number of whole tiles in a source of the given size
+    static int tileCount(const QSize& sourceSize, const ProjectSettings& settings);
+
+    // Content hash of a source image, never 0 so 0 can mean "not computed yet"
+    static quint64 sourceKey(const QImage& image);
+
+    // Bump whenever the padded or unpadded pixels of the same settings change,
+    // so results stored by earlier builds (the disk cache) are not used anymore
+    static constexpr int AlgorithmVersion = 2; // 2: PaddingRemover clears its target
+
+    // Only the settings fields the result depends on
+    static QByteArray settingsKey(const ProjectSettings& settings);
+};
+
+#endif // TILEPROCESSOR_H
@@ -0,0 +1,145 @@
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <chrono>
+
+std::atomic<bool> Trace::s_enabled{false};
+QMutex Trace::s_mutex;
+QFile* Trace::s_file = nullptr;
+std::atomic<qint64> Trace::s_epochNs{0};
+int Trace::s_lanes = 0;
+int Trace::s_recording = 0;
+
+static qint64 monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Lane of the calling thread, 0 until the thread records its first event, and
+// the recording its name was last written to
+static thread_local int t_lane = 0;
+static thread_local int t_recording = 0;
+
+bool Trace::start(const QString& path) {
+    stop();
+    QMutexLocker locker(&s_mutex);
+    s_file = new QFile(path);
+    if (!s_file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        delete s_file;
+        s_file = nullptr;
+        return false;
+    }
+    // The closing bracket is optional in the trace format, an interrupted run stays readable
+    s_file->write("[\n");
+    s_recording++;
+    s_epochNs = monotonicNs();
+    s_enabled = true;
+    return true;
+}
+
+void Trace::stop() {
+    QMutexLocker locker(&s_mutex);
+    if (!s_file) {
+        return;
+    }
+    s_enabled = false;
+    // Names the process, and leaves no trailing comma after the last event
+    s_file->write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"TilePad\"}}\n]\n");
+    s_file->close();
+    delete s_file;
+    s_file = nullptr;
+}
+
+qint64 Trace::now() {
+    return monotonicNs() - s_epochNs.load(std::memory_order_relaxed);
+}
+
+int Trace::threadLane() {
+    int recording;
+    {
+        QMutexLocker locker(&s_mutex);
+        if (t_lane == 0) {
+            t_lane = ++s_lanes;
+        }
+        recording = s_recording;
+    }
+    // Every recording names the lanes it uses
+    if (t_recording != recording) {
+        t_recording = recording;
+        QJsonObject meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = 1;
+        meta["tid"] = t_lane;
+        bool mainThread = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread();
+        meta["args"] = QJsonObject{{ "name", mainThread ? QString("Main thread") : QString("Worker %1").arg(t_lane) }};
+        writeEvent(QJsonDocument(meta).toJson(QJsonDocument::Compact));
+    }
+    return t_lane;
+}
+
+void Trace::writeEvent(const QByteArray& json) {
+    QMutexLocker locker(&s_mutex);
+    if (s_file) {
+        s_file->write(json + ",\n");
+    }
+}
+
+void Trace::complete(const char* name, quint64 fileId, qint64 startNs) {
+    qint64 endNs = now();
+    int lane = threadLane();
+
+    QJsonObject event;
+    event["name"] = name;
+    event["cat"] = "stage";
+    event["ph"] = "X";
+    event["ts"] = startNs / 1000.0;
+    event["dur"] = (endNs - startNs) / 1000.0;
+    event["pid"] = 1;
+    event["tid"] = lane;
+    if (fileId != 0) {
+        event["args"] = QJsonObject{{ "file", qint64(fileId) }};
+    }
+    writeEvent(QJsonDocument(event).toJson(QJsonDocument::Compact));
+}
+
+void Trace::beginJob(quint64 id, quint64 fileId, const QString& name) {
+    if (!isEnabled()) {
+        return;
+    }
+    QJsonObject event;
+    event["name"] = name;
+    event["cat"] = "file";
+    event["ph"] = "b";
+    event["id"] = qint64(id);
+    event["ts"] = now() / 1000.0;
+    event["pid"] = 1;
+    event["args"] = QJsonObject{{ "file", qint64(fileId) }};
+    writeEvent(QJsonDocument(event).toJson(QJsonDocument::Compact));
+}
+
+void Trace::endJob(quint64 id, quint64 fileId, const QString& name) {
+    if (!isEnabled()) {
+        return;
+    }
+    QJsonObject event;
+    event["name"] = name;
+    event["cat"] = "file";
+    event["ph"] = "e";
+    event["id"] = qint64(id);
+    event["ts"] = now() / 1000.0;
+    event["pid"] = 1;
+    event["args"] = QJsonObject{{ "file", qint64(fileId) }};
+    writeEvent(QJsonDocument(event).toJson(QJsonDocument::Compact));
+
+    // A run that is killed keeps every job that finished
+    QMutexLocker locker(&s_mutex);
+    if (s_file) {
+        s_file->flush();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QFile>
+#include <QMutex>
+
+#include <atomic>
+
+// Records how long the processing stages take, as Chrome trace events that
+// can be opened in chrome://tracing or ui.perfetto.dev. Every thread gets a
+// lane with its stages, and every job a span in the lane of its file.
+// Events are written to the file as they happen, so the trace of a run that
+// is killed can still be opened. When recording is off, a TraceScope costs
+// one atomic load.
+class Trace
+{
+public:
+    // Starts writing events to the file, returns false if it can't be created
+    static bool start(const QString& path);
+    static void stop();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Nanoseconds since start()
+    static qint64 now();
+
+    // A stage that ran on the calling thread from startNs until now
+    static void complete(const char* name, quint64 fileId, qint64 startNs);
+
+    // A job of a file, from submit to delivery. The id must be unique per job.
+    static void beginJob(quint64 id, quint64 fileId, const QString& name);
+    static void endJob(quint64 id, quint64 fileId, const QString& name);
+
+private:
+    static int threadLane();
+    static void writeEvent(const QByteArray& json);
+
+    static std::atomic<bool> s_enabled;
+    static QMutex s_mutex;
+    static QFile* s_file;
+    static std::atomic<qint64> s_epochNs; // Monotonic time of start(), read by every thread
+    static int s_lanes;
+    static int s_recording;
+};
+
+// Times the enclosing block as a stage of the file
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name, quint64 fileId = 0)
+        : m_name(Trace::isEnabled() ? name : nullptr), m_fileId(fileId), m_start(m_name ? Trace::now() : 0) {
+    }
+
+    ~TraceScope() {
+        if (m_name) {
+            Trace::complete(m_name, m_fileId, m_start);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    quint64 m_fileId;
+    qint64 m_start;
+};
+
+#endif // TRACE_H
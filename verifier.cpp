@@ -0,0 +1,305 @@
+#include "verifier.h"
+#include "paddinggenerator.h"
+#include "paddingremover.h"
+#include "tileprocessor.h"
+#include "paddingengine.h"
+
+#include <QColor>
+#include <QList>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+// The padded target of a case stays around this size, so the reference
+// implementation finishes a case in well under a second
+static const int MaxTargetSize = 2048;
+static const int MaxBands = 8;
+
+// Source formats the generator gets from decoders
+static const struct {
+    QImage::Format format;
+    const char* name;
+} SourceFormats[] = {
+    { QImage::Format_ARGB32, "ARGB32" },
+    { QImage::Format_ARGB32_Premultiplied, "ARGB32_Premultiplied" },
+    { QImage::Format_RGB32, "RGB32" },
+    { QImage::Format_RGB888, "RGB888" },
+    { QImage::Format_RGBA8888, "RGBA8888" },
+    { QImage::Format_Grayscale8, "Grayscale8" },
+    { QImage::Format_Indexed8, "Indexed8" },
+};
+
+static void print(FILE* stream, const QString& text) {
+    fputs((text + "\n").toStdString().c_str(), stream);
+    fflush(stream);
+}
+
+static bool pixelFormat(QImage::Format format, PixelFormat* result) {
+    switch (format) {
+    case QImage::Format_ARGB32:
+        *result = PixelFormat::Argb32;
+        return true;
+    case QImage::Format_ARGB32_Premultiplied:
+        *result = PixelFormat::Argb32Premultiplied;
+        return true;
+    case QImage::Format_RGBA8888:
+        *result = PixelFormat::Rgba8888;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static PixelView viewOf(QImage& image, PixelFormat format) {
+    PixelView view;
+    view.data = image.bits();
+    view.width = image.width();
+    view.height = image.height();
+    view.stride = image.bytesPerLine();
+    view.format = format;
+    return view;
+}
+
+static const char* formatName(QImage::Format format) {
+    for (const auto& entry : SourceFormats) {
+        if (entry.format == format) {
+            return entry.name;
+        }
+    }
+    return "other";
+}
+
+// Mostly small values, but every value of the range occurs
+static int skewedSize(QRandomGenerator& random, int min, int max) {
+    int bucket = random.bounded(10);
+    int limit = bucket < 6 ? qMin(max, min + 7) : bucket < 9 ? qMin(max, min + max / 4) : max;
+    return min + random.bounded(limit - min + 1);
+}
+
+Verifier::Case Verifier::randomCase(QRandomGenerator& random) {
+    Case testCase;
+    ProjectSettings& settings = testCase.settings;
+    settings.tileWidth = skewedSize(random, 1, 512);
+    settings.tileHeight = random.bounded(3) == 0 ? settings.tileWidth : skewedSize(random, 1, 512);
+    settings.padding = skewedSize(random, 0, 64);
+    settings.forcePot = random.bounded(2) == 1;
+    settings.reorder = random.bounded(2) == 1;
+    settings.transparent = random.bounded(2) == 1;
+    settings.backgroundColor = QColor::fromRgba(random.generate()).name(QColor::HexArgb);
+
+    int gridWidth = settings.tileWidth + settings.padding * 2;
+    int gridHeight = settings.tileHeight + settings.padding * 2;
+    int cols = 1 + random.bounded(qMax(1, MaxTargetSize / gridWidth));
+    int rows = 1 + random.bounded(qMax(1, MaxTargetSize / gridHeight));
+    // Pixels right of and below the last whole tile are ignored
+    int extraWidth = random.bounded(settings.tileWidth);
+    int extraHeight = random.bounded(settings.tileHeight);
+
+    // Noise with fully opaque, fully transparent and translucent pixels
+    QImage image(cols * settings.tileWidth + extraWidth, rows * settings.tileHeight + extraHeight, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); y++) {
+        quint32* line = reinterpret_cast<quint32*>(image.scanLine(y));
+        random.fillRange(line, image.width());
+        for (int x = 0; x < image.width(); x++) {
+            switch (line[x] >> 30) {
+            case 0:
+                line[x] &= 0x00ffffff;
+                break;
+            case 1:
+            case 2:
+                line[x] |= 0xff000000;
+                break;
+            }
+        }
+    }
+    int format = random.bounded(int(std::size(SourceFormats)));
+    testCase.source = image.convertToFormat(SourceFormats[format].format);
+    return testCase;
+}
+
+QString Verifier::describe(const Case& testCase) {
+    const ProjectSettings& settings = testCase.settings;
+    QString text = QString("tile %1x%2, padding %3, source %4x%5 %6")
+        .arg(settings.tileWidth)
+        .arg(settings.tileHeight)
+        .arg(settings.padding)
+        .arg(testCase.source.width())
+        .arg(testCase.source.height())
+        .arg(formatName(testCase.source.format()));
+    if (settings.forcePot) {
+        text += ", force PoT";
+    }
+    if (settings.reorder) {
+        text += ", reorder";
+    }
+    text += settings.transparent ? ", transparent" : ", background " + settings.backgroundColor;
+    return text;
+}
+
+QString Verifier::compare(const QImage& expected, const QImage& actual) {
+    if (expected.size() != actual.size()) {
+        return QString("size %1x%2, expected %3x%4")
+            .arg(actual.width()).arg(actual.height()).arg(expected.width()).arg(expected.height());
+    }
+    if (expected.format() != actual.format()) {
+        return QString("format %1, expected %2").arg(int(actual.format())).arg(int(expected.format()));
+    }
+    qsizetype rowBytes = qsizetype(expected.width()) * expected.depth() / 8;
+    for (int y = 0; y < expected.height(); y++) {
+        const uchar* a = expected.constScanLine(y);
+        const uchar* b = actual.constScanLine(y);
+        if (memcmp(a, b, rowBytes) == 0) {
+            continue;
+        }
+        for (int x = 0; x < expected.width(); x++) {
+            if (expected.pixel(x, y) != actual.pixel(x, y)) {
+                return QString("pixel %1,%2 is #%3, expected #%4").arg(x).arg(y)
+                    .arg(actual.pixel(x, y), 8, 16, QChar('0'))
+                    .arg(expected.pixel(x, y), 8, 16, QChar('0'));
+            }
+        }
+        return QString("row %1 differs").arg(y);
+    }
+    return QString();
+}
+
+QImage Verifier::gridCells(const QImage& padded, const ProjectSettings& settings) {
+    int gridWidth = settings.tileWidth + settings.padding * 2;
+    int gridHeight = settings.tileHeight + settings.padding * 2;
+    int cols = padded.width() / gridWidth;
+    int rows = padded.height() / gridHeight;
+    QImage result(cols * settings.tileWidth, rows * settings.tileHeight, QImage::Format_ARGB32);
+    qsizetype tileBytes = qsizetype(settings.tileWidth) * 4;
+    for (int j = 0; j < rows; j++) {
+        for (int y = 0; y < settings.tileHeight; y++) {
+            const uchar* from = padded.constScanLine(j * gridHeight + settings.padding + y);
+            uchar* to = result.scanLine(j * settings.tileHeight + y);
+            for (int i = 0; i < cols; i++) {
+                memcpy(to + i * tileBytes, from + qsizetype(i * gridWidth + settings.padding) * 4, tileBytes);
+            }
+        }
+    }
+    return result;
+}
+
+int Verifier::run(int cases, quint32 seed) {
+    print(stdout, QString("Verifying %1 cases with seed %2").arg(cases).arg(seed));
+    QRandomGenerator random(seed);
+    int failed = 0;
+    for (int n = 0; n < cases; n++) {
+        Case testCase = randomCase(random);
+        const ProjectSettings& settings = testCase.settings;
+
+        // The reference: QPainter for the tiles, setPixel() for the edges
+        PaddingGenerator generator;
+        TileProcessor::configure(generator, settings);
+        QImage source = testCase.source;
+        QImage reference = *generator.create(&source);
+
+        QList<QPair<QString, QImage>> results;
+        results.append(qMakePair(QString("process"), TileProcessor::process(testCase.source, settings)));
+
+        // Bands split at random rows, rendered in random order
+        PaddingGenerator banded;
+        TileProcessor::configure(banded, settings);
+        QImage bandSource = testCase.source;
+        QImage* target = banded.prepare(&bandSource);
+        int rowCount = banded.bandRowCount();
+        QList<int> cuts;
+        int bands = 1 + random.bounded(qMax(1, qMin(rowCount, MaxBands)));
+        for (int b = 1; b < bands; b++) {
+            cuts.append(random.bounded(rowCount + 1));
+        }
+        cuts.append(0);
+        cuts.append(rowCount);
+        std::sort(cuts.begin(), cuts.end());
+        cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+        QList<QPair<int, int>> ranges;
+        for (int b = 0; b + 1 < cuts.size(); b++) {
+            ranges.append(qMakePair(cuts[b], cuts[b + 1]));
+        }
+        for (int b = ranges.size() - 1; b > 0; b--) {
+            ranges.swapItemsAt(b, random.bounded(b + 1));
+        }
+        for (const auto& range : ranges) {
+            banded.renderBand(bandSource, range.first, range.second);
+        }
+        results.append(qMakePair(QString("bands"), *target));
+
+        // The raw buffer API of tilepad_core, for the source formats it takes:
+        // in one piece, and cleared once with the same bands rendered on threads
+        PixelFormat sourceFormat;
+        if (pixelFormat(testCase.source.format(), &sourceFormat)) {
+            QImage engineSource = testCase.source;
+            PixelView sourceView = viewOf(engineSource, sourceFormat);
+            PaddingOptions options = TileProcessor::options(settings);
+            PaddingLayout layout = PaddingEngine::layout(sourceView.width, sourceView.height, options);
+
+            QImage padded(layout.width, layout.height, QImage::Format_ARGB32);
+            if (!PaddingEngine::pad(sourceView, viewOf(padded, PixelFormat::Argb32), options)) {
+                padded = QImage();
+            }
+            results.append(qMakePair(QString("engine"), padded));
+
+            QImage engineBands(layout.width, layout.height, QImage::Format_ARGB32);
+            PixelView targetView = viewOf(engineBands, PixelFormat::Argb32);
+            std::atomic<bool> ok { PaddingEngine::clear(targetView, options) };
+            QThreadPool pool;
+            for (const auto& range : ranges) {
+                pool.start([&, range]() {
+                    if (!PaddingEngine::renderBand(sourceView, targetView, options, range.first, range.second)) {
+                        ok = false;
+                    }
+                });
+            }
+            pool.waitForDone();
+            results.append(qMakePair(QString("engineBands"), ok ? engineBands : QImage()));
+        }
+
+        QList<QString> failures;
+        for (const auto& result : results) {
+            QString difference = compare(reference, result.second);
+            if (!difference.isEmpty()) {
+                failures.append(result.first + ": " + difference);
+                QString prefix = QString("verify-%1-%2").arg(n).arg(result.first);
+                reference.save(prefix + "-expected.png");
+                result.second.save(prefix + "-actual.png");
+            }
+        }
+
+        // Removing the padding again gives back the tiles of the grid cells.
+        // Drawing converts through premultiplied alpha, so the colors of
+        // translucent pixels are compared premultiplied.
+        PaddingRemover remover;
+        remover.setTileSize(settings.tileWidth, settings.tileHeight);
+        remover.setPadding(settings.padding);
+        QImage removed = remover.create(&reference)->convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        QImage cells = gridCells(reference, settings).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        QString difference = compare(cells, removed);
+        if (!difference.isEmpty()) {
+            failures.append("remove: " + difference);
+            QString prefix = QString("verify-%1-remove").arg(n);
+            cells.save(prefix + "-expected.png");
+            removed.save(prefix + "-actual.png");
+        }
+
+        if (!failures.isEmpty()) {
+            failed++;
+            print(stderr, QString("Case %1 failed: %2").arg(n).arg(describe(testCase)));
+            for (const QString& failure : failures) {
+                print(stderr, "  " + failure);
+            }
+        }
+    }
+
+    if (failed > 0) {
+        print(stderr, QString("%1 of %2 cases failed (seed %3)").arg(failed).arg(cases).arg(seed));
+        return 1;
+    }
+    print(stdout, QString("All %1 cases passed").arg(cases));
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <QImage>
+#include <QString>
+#include <QRandomGenerator>
+
+#include "projectsettings.h"
+
+// Golden-image check of the fast padding paths against the reference
+// implementation (PaddingGenerator::create(), QPainter and setPixel). Random
+// cases cover tile sizes 1-512, paddings 0-64, Force PoT and reorder, solid
+// and transparent backgrounds and several source pixel formats. Compared
+// byte for byte:
+//   - TileProcessor::process(), the single band path of the CLI
+//   - prepare() and renderBand() over random band splits rendered in random
+//     order, as the worker does on several threads
+//   - PaddingEngine::pad(), the raw buffer API, for 32-bit sources, and its
+//     clear() with the same bands rendered concurrently by renderBand()
+// PaddingRemover::create() is checked by removing the padding from the
+// reference again, which has to give back the tiles of its grid cells.
+class Verifier
+{
+public:
+    // Runs the cases, prints every mismatch and saves its images to the
+    // current directory. Returns the exit code.
+    static int run(int cases, quint32 seed);
+
+private:
+    struct Case {
+        ProjectSettings settings;
+        QImage source;
+    };
+
+    static Case randomCase(QRandomGenerator& random);
+    static QString describe(const Case& testCase);
+
+    // Empty if the images are equal, otherwise the first difference
+    static QString compare(const QImage& expected, const QImage& actual);
+
+    // The padded image without its padding, cut out cell by cell
+    static QImage gridCells(const QImage& padded, const ProjectSettings& settings);
+};
+
+#endif // VERIFIER_H
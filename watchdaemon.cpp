@@ -0,0 +1,238 @@
+#include "watchdaemon.h"
+#include "cli.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+
+#include <cstdio>
+
+// Milliseconds without further events before the changes are processed. Editors
+// write a file in several steps, this collects them into one job.
+static const int CoalesceDelay = 20;
+
+static void print(FILE* stream, const QString& text) {
+    fputs((text + "\n").toStdString().c_str(), stream);
+    fflush(stream);
+}
+
+WatchDaemon::WatchDaemon(const QString& root, const QString& outputPattern, const ProjectSettings& settings, int jobs,
+                         QObject* parent)
+    : QObject(parent), m_root(QDir(root).absolutePath()), m_pattern(outputPattern), m_settings(settings) {
+    for (const QByteArray& format : QImageReader::supportedImageFormats()) {
+        m_nameFilters.append("*." + QString::fromLatin1(format));
+    }
+    if (jobs > 0) {
+        m_worker.setMaxThreadCount(jobs);
+    }
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(CoalesceDelay);
+    connect(&m_timer, &QTimer::timeout, this, &WatchDaemon::processChanges);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &WatchDaemon::directoryChanged);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &WatchDaemon::fileChanged);
+    connect(&m_worker, &ProcessingWorker::fileProcessed, this, &WatchDaemon::fileProcessed);
+}
+
+void WatchDaemon::setDiskCache(DiskCache* cache) {
+    m_worker.setDiskCache(cache);
+}
+
+int WatchDaemon::run() {
+    if (!QFileInfo(m_root).isDir()) {
+        print(stderr, QString("Error: Not a directory: %1").arg(m_root));
+        return 1;
+    }
+    // Files whose output is missing or older are brought up to date first
+    scanDirectory(m_root, true);
+    print(stdout, QString("Watching %1 (%2 images). Press Ctrl+C to stop.").arg(m_root).arg(m_inputs.size()));
+    m_loop.exec();
+    return 0;
+}
+
+void WatchDaemon::directoryChanged(const QString& path) {
+    if (m_changedDirs.isEmpty() && m_changedFiles.isEmpty()) {
+        m_firstChange.start();
+    }
+    m_changedDirs.insert(path);
+    m_timer.start();
+}
+
+void WatchDaemon::fileChanged(const QString& path) {
+    if (m_changedDirs.isEmpty() && m_changedFiles.isEmpty()) {
+        m_firstChange.start();
+    }
+    m_changedFiles.insert(path);
+    m_timer.start();
+}
+
+void WatchDaemon::processChanges() {
+    QSet<QString> dirs = m_changedDirs;
+    QSet<QString> files = m_changedFiles;
+    m_changedDirs.clear();
+    m_changedFiles.clear();
+
+    for (const QString& dir : dirs) {
+        if (QFileInfo(dir).isDir()) {
+            scanDirectory(dir, false);
+        } else {
+            // Removed with everything below it
+            QString prefix = dir + "/";
+            m_watchedDirs.remove(dir);
+            for (auto it = m_watchedDirs.begin(); it != m_watchedDirs.end();) {
+                it = it->startsWith(prefix) ? m_watchedDirs.erase(it) : std::next(it);
+            }
+            for (auto it = m_inputsByDir.begin(); it != m_inputsByDir.end();) {
+                if (it.key() != dir && !it.key().startsWith(prefix)) {
+                    ++it;
+                    continue;
+                }
+                for (const QString& file : it.value()) {
+                    m_inputs.remove(file);
+                }
+                it = m_inputsByDir.erase(it);
+            }
+        }
+    }
+    for (const QString& file : files) {
+        // The watch is lost when an editor replaces the file, the directory event re-adds it
+        if (QFileInfo::exists(file) && !m_watcher.files().contains(file)) {
+            m_watcher.addPath(file);
+        }
+        checkFile(file, false);
+    }
+}
+
+void WatchDaemon::scanDirectory(const QString& path, bool initial) {
+    if (!m_watchedDirs.contains(path)) {
+        m_watcher.addPath(path);
+        m_watchedDirs.insert(path);
+    }
+    QDir dir(path);
+
+    // At startup the whole tree, afterwards only new subdirectories: changes in
+    // known ones come with their own events
+    for (const QString& name : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QString subdir = dir.filePath(name);
+        if (initial || !m_watchedDirs.contains(subdir)) {
+            scanDirectory(subdir, initial);
+        }
+    }
+
+    QStringList watchedFiles = m_watcher.files();
+    QSet<QString> watched(watchedFiles.begin(), watchedFiles.end());
+    QSet<QString> present;
+    QStringList unwatched;
+    for (const QString& name : dir.entryList(m_nameFilters, QDir::Files)) {
+        QString file = dir.filePath(name);
+        if (!isInput(file)) {
+            continue;
+        }
+        present.insert(file);
+        if (!watched.contains(file)) {
+            unwatched.append(file);
+        }
+        checkFile(file, initial);
+    }
+    if (!unwatched.isEmpty()) {
+        m_watcher.addPaths(unwatched);
+    }
+
+    // Files gone from the directory, only its own inputs are compared
+    auto inputs = m_inputsByDir.find(path);
+    if (inputs == m_inputsByDir.end()) {
+        return;
+    }
+    for (auto it = inputs->begin(); it != inputs->end();) {
+        if (present.contains(*it)) {
+            ++it;
+            continue;
+        }
+        m_inputs.remove(*it);
+        it = inputs->erase(it);
+    }
+    if (inputs->isEmpty()) {
+        m_inputsByDir.erase(inputs);
+    }
+}
+
+void WatchDaemon::checkFile(const QString& path, bool initial) {
+    if (!isInput(path)) {
+        return;
+    }
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return; // Removed, or not yet renamed into place: the directory event follows
+    }
+    InputFile& input = m_inputs[path];
+    bool known = input.fileId != 0;
+    if (!known) {
+        input.fileId = m_nextFileId++;
+        m_inputsByDir[info.absolutePath()].insert(path);
+    }
+    if (known && input.modified == info.lastModified() && input.size == info.size()) {
+        return;
+    }
+    input.modified = info.lastModified();
+    input.size = info.size();
+
+    if (initial) {
+        QFileInfo output(Cli::outputPathFor(path, m_pattern));
+        if (output.exists() && output.lastModified() >= info.lastModified()) {
+            return;
+        }
+    }
+    submit(path);
+}
+
+void WatchDaemon::submit(const QString& input) {
+    // A newer change of the same file supersedes a job still running for it
+    quint64 fileId = m_inputs[input].fileId;
+    Pending& pending = m_pending[fileId];
+    pending.input = input;
+    pending.output = Cli::outputPathFor(input, m_pattern);
+    if (m_firstChange.isValid()) {
+        pending.timer = m_firstChange;
+    } else {
+        pending.timer.start();
+    }
+    m_outputs.insert(QFileInfo(pending.output).absoluteFilePath());
+
+    ProcessingJob job;
+    job.fileId = fileId;
+    job.sourcePath = input;
+    job.settings = m_settings;
+    job.exportPath = pending.output;
+    job.keepImage = false;
+    m_worker.submit(job);
+}
+
+void WatchDaemon::fileProcessed(const ProcessingResult& result) {
+    auto it = m_pending.find(result.fileId);
+    if (it == m_pending.end()) {
+        return;
+    }
+    const Pending& pending = it.value();
+    double ms = pending.timer.nsecsElapsed() / 1000000.0;
+    if (!result.error.isEmpty()) {
+        print(stderr, "Error: " + result.error);
+    } else if (result.exportResult == ImageWriter::Result::Failed) {
+        print(stderr, QString("Error: Could not save image: %1").arg(pending.output));
+    } else if (result.exportResult == ImageWriter::Result::Skipped) {
+        print(stdout, QString("Unchanged: %1 (%2 ms)").arg(pending.output).arg(ms, 0, 'f', 1));
+    } else {
+        print(stdout, QString("Saved: %1 (%2 ms)").arg(pending.output).arg(ms, 0, 'f', 1));
+    }
+    m_pending.erase(it);
+}
+
+bool WatchDaemon::isInput(const QString& path) const {
+    QFileInfo info(path);
+    if (m_outputs.contains(info.absoluteFilePath())) {
+        return false;
+    }
+    // Exports with the default pattern, also ones left from earlier runs
+    if (info.completeBaseName().endsWith(".export")) {
+        return false;
+    }
+    return QDir::match(m_nameFilters, info.fileName());
+}
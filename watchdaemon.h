@@ -0,0 +1,71 @@
+#ifndef WATCHDAEMON_H
+#define WATCHDAEMON_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include "processingworker.h"
+
+// Watches a directory tree and pads every image that appears or changes in
+// it, until the process is stopped. Outputs are named by the same pattern as
+// in batch mode, and files written by the daemon are never taken as inputs.
+class WatchDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    WatchDaemon(const QString& root, const QString& outputPattern, const ProjectSettings& settings, int jobs,
+                QObject* parent = nullptr);
+
+    // Finished exports are looked up and stored here, may be null
+    void setDiskCache(DiskCache* cache);
+
+    int run();
+
+private:
+    struct InputFile {
+        quint64 fileId = 0;
+        QDateTime modified;
+        qint64 size = -1;
+    };
+
+    struct Pending {
+        QString input;
+        QString output;
+        QElapsedTimer timer; // Started at the first change event
+    };
+
+    void directoryChanged(const QString& path);
+    void fileChanged(const QString& path);
+    void processChanges();
+    void scanDirectory(const QString& path, bool initial);
+    void checkFile(const QString& path, bool initial);
+    void submit(const QString& input);
+    void fileProcessed(const ProcessingResult& result);
+    bool isInput(const QString& path) const;
+
+    QString m_root;
+    QString m_pattern;
+    ProjectSettings m_settings;
+    QStringList m_nameFilters;
+    QFileSystemWatcher m_watcher;
+    ProcessingWorker m_worker;
+    QTimer m_timer;
+    QHash<QString, InputFile> m_inputs;
+    QHash<QString, QSet<QString>> m_inputsByDir; // The keys of m_inputs by their directory
+    QSet<QString> m_outputs;
+    QSet<QString> m_watchedDirs;
+    QSet<QString> m_changedDirs;
+    QSet<QString> m_changedFiles;
+    QElapsedTimer m_firstChange;
+    QHash<quint64, Pending> m_pending;
+    quint64 m_nextFileId = 1;
+    QEventLoop m_loop;
+};
+
+#endif // WATCHDAEMON_H